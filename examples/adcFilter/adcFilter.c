@@ -0,0 +1,156 @@
+#include <armory/filter.h>
+#include <armory/gpio.h>
+#include <armory/timing.h>
+#include <stdint.h>
+
+// Measures the cycles per sample of the DSP filters in filter.h against
+// plain C loops doing the same job one sample at a time.
+//
+// The input is a generated noisy ramp, no ADC input needs to be connected.
+//
+// Wiring:
+//  LED -> PC13 (lights up once the results are ready)
+//
+// The results are left in filterResults below, in tenths of a cycle per
+// input sample, along with how far the DSP outputs are from the plain C
+// ones (both should be 0). Read them out with a debugger (e.g.
+// `print filterResults` in gdb), and build with `make EXTRA_CFLAGS=-O2` as
+// well.
+
+#define LED_PIN C13
+
+#define BLOCK_SIZE 1024
+
+// Filter settings, 16x oversampling with 2 extra bits
+#define DECIMATE_LOG2  4
+#define EXTRA_BITS     2
+#define WINDOW         32
+#define IIR_ALPHA      2048 // 1/16 in Q15
+
+typedef struct {
+    uint32_t cCycles;
+    uint32_t dspCycles;
+    uint32_t mismatches;    // Outputs that differ between C and DSP
+    uint32_t maxError;      // Largest difference between them
+} FilterResult;
+
+// Decimate, moving average, IIR
+volatile FilterResult filterResults[3];
+
+static uint16_t input[BLOCK_SIZE] __attribute__((aligned(4)));
+static uint16_t output[BLOCK_SIZE] __attribute__((aligned(4)));
+static uint16_t expected[BLOCK_SIZE];
+static uint16_t history[WINDOW] __attribute__((aligned(4)));
+
+// A ramp with pseudo-random noise, kept within 12 bits
+static void fillInput(void) {
+    uint32_t seed = 12345;
+
+    for(int i = 0; i < BLOCK_SIZE; i++) {
+        seed = seed * 1664525 + 1013904223;
+        input[i] = (i * 3 + ((seed >> 24) & 0x3F)) & 0x0FFF;
+    }
+}
+
+static void decimateC(void) {
+    for(int i = 0; i < BLOCK_SIZE >> DECIMATE_LOG2; i++) {
+        uint32_t sum = 0;
+        for(int j = 0; j < (1 << DECIMATE_LOG2); j++) {
+            sum += input[(i << DECIMATE_LOG2) + j];
+        }
+        expected[i] = sum >> (DECIMATE_LOG2 - EXTRA_BITS);
+    }
+}
+
+static void movingAverageC(void) {
+    uint32_t sum = 0;
+    int index = 0;
+
+    for(int i = 0; i < WINDOW; i++) {
+        history[i] = 0;
+    }
+
+    for(int i = 0; i < BLOCK_SIZE; i++) {
+        sum += input[i] - history[index];
+        history[index] = input[i];
+        index = (index + 1) % WINDOW;
+        expected[i] = (sum + WINDOW / 2) / WINDOW;
+    }
+}
+
+// Same arithmetic as filterIir: 15 fraction bits, the difference taken
+// from the rounded output
+static void iirC(void) {
+    int32_t acc = input[0] << 15;
+
+    for(int i = 0; i < BLOCK_SIZE; i++) {
+        acc += IIR_ALPHA * (input[i] - ((acc + (1 << 14)) >> 15));
+        expected[i] = (acc + (1 << 14)) >> 15;
+    }
+}
+
+static void decimateDsp(void) {
+    filterDecimate(input, BLOCK_SIZE, DECIMATE_LOG2, EXTRA_BITS, output);
+}
+
+static void movingAverageDsp(void) {
+    MovingAverage f;
+    filterMovingAverageInit(&f, history, WINDOW);
+    filterMovingAverage(&f, input, output, BLOCK_SIZE);
+}
+
+static void iirDsp(void) {
+    IirFilter f;
+    filterIirInit(&f, IIR_ALPHA, input[0]);
+    filterIir(&f, input, output, BLOCK_SIZE);
+}
+
+// Tenths of a cycle per input sample
+static uint32_t bench(void (*filter)(void)) {
+    uint32_t start = DWT_CYCCNT;
+    filter();
+    return (DWT_CYCCNT - start) * 10 / BLOCK_SIZE;
+}
+
+// Compares the outputs of the DSP version against the C one
+static void compare(volatile FilterResult *result, int count) {
+    result->mismatches = 0;
+    result->maxError = 0;
+
+    for(int i = 0; i < count; i++) {
+        uint32_t error = (output[i] > expected[i]) ? output[i] - expected[i] : expected[i] - output[i];
+        if(error != 0) {
+            result->mismatches++;
+        }
+        if(error > result->maxError) {
+            result->maxError = error;
+        }
+    }
+}
+
+int main(void) {
+    timingInit();
+
+    gpioInit(GPIOC);
+    gpioPinMode(LED_PIN, OUTPUT);
+    gpioWrite(LED_PIN, HIGH);
+
+    fillInput();
+
+    filterResults[0].cCycles = bench(decimateC);
+    filterResults[0].dspCycles = bench(decimateDsp);
+    compare(&filterResults[0], BLOCK_SIZE >> DECIMATE_LOG2);
+
+    filterResults[1].cCycles = bench(movingAverageC);
+    filterResults[1].dspCycles = bench(movingAverageDsp);
+    compare(&filterResults[1], BLOCK_SIZE);
+
+    filterResults[2].cCycles = bench(iirC);
+    filterResults[2].dspCycles = bench(iirDsp);
+    compare(&filterResults[2], BLOCK_SIZE);
+
+    // Results ready, onboard LED is active low
+    gpioWrite(LED_PIN, LOW);
+
+    while(1);
+}
@@ -0,0 +1,83 @@
+#include <armory/adc.h>
+#include <armory/gpio.h>
+#include <armory/tim.h>
+#include <stdint.h>
+
+// Keeps two slow inputs scanned in the background while a third is sampled
+// at a fixed 10 kHz through the injected group, which cuts in ahead of the
+// scan. The delay from each TIM2 update to the injected callback is kept to
+// show that the scan does not hold the urgent channel back.
+//
+// Wiring:
+//  Urgent signal -> PA0 (0 - 3.3 V, e.g. a current sense amplifier)
+//  Slow inputs   -> PA1, PA2 (e.g. potentiometers)
+//  LED           -> PC13 (toggles every 10000 injected conversions)
+//
+// Read the results with a debugger (e.g. `print latencyMax` in gdb), the
+// latencies are in CPU cycles.
+
+#define URGENT_PIN  A0
+#define SLOW_PIN_1  A1
+#define SLOW_PIN_2  A2
+#define LED_PIN     C13
+
+#define INJECTED_RATE 10000
+
+static volatile uint16_t slowValues[2];
+
+// Last injected result, and the update to callback delay seen so far
+volatile uint16_t urgentValue;
+volatile uint32_t conversions;
+volatile uint32_t latencyMin = UINT32_MAX;
+volatile uint32_t latencyMax;
+volatile uint32_t injectedRate;
+
+static void injectedDone(const uint16_t results[], uint8_t count, void *context) {
+    // TIM2 counts CPU cycles from the update that started the conversion
+    uint32_t latency = TIM2->CNT;
+
+    urgentValue = results[0];
+
+    if(latency < latencyMin) {
+        latencyMin = latency;
+    }
+    if(latency > latencyMax) {
+        latencyMax = latency;
+    }
+
+    conversions++;
+    if(conversions % 10000 == 0) {
+        gpioToggleFast(LED_PIN);
+    }
+}
+
+int main(void) {
+    gpioInit(GPIOA);
+    gpioInit(GPIOC);
+    gpioPinMode(URGENT_PIN, ANALOG);
+    gpioPinMode(SLOW_PIN_1, ANALOG);
+    gpioPinMode(SLOW_PIN_2, ANALOG);
+    gpioPinMode(LED_PIN, OUTPUT);
+
+    adcInit();
+
+    // The slow inputs get long sample times and convert back to back
+    static const AdcChannel slowChannels[] = { CHANNEL_1, CHANNEL_2 };
+    adcSetSampleTime(CHANNEL_1, ADC_SAMPLE_480);
+    adcSetSampleTime(CHANNEL_2, ADC_SAMPLE_480);
+    adcScanStart(slowChannels, 2, slowValues);
+
+    // The urgent input is converted on every TIM2 update
+    static const AdcChannel urgentChannels[] = { CHANNEL_0 };
+    adcSetSampleTime(CHANNEL_0, ADC_SAMPLE_15);
+    adcInjectedInit(urgentChannels, 1, ADC_INJECTED_TIM2_TRGO, injectedDone, NULL);
+
+    timInit(TIM2);
+    injectedRate = timSetUpdateRate(TIM2, INJECTED_RATE);
+    TIM2->CR2 = (TIM2->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_UPDATE;
+    TIM2->CR1 |= TIM_CR1_CEN;
+
+    while(1) {
+        __asm__ volatile ("wfi");
+    }
+}
@@ -0,0 +1,120 @@
+#include <armory/adc.h>
+#include <armory/filter.h>
+#include <armory/gpio.h>
+#include <stdint.h>
+
+// Samples one input at a fixed 200 kSPS, paced by TIM2, and keeps running
+// statistics of each block while the next one is being filled by DMA. Each
+// block also goes through a moving average, and the spread of the raw and
+// filtered samples is kept side by side to show the noise it removes.
+//
+// Wiring:
+//  Signal -> PA1 (0 - 3.3 V, e.g. a potentiometer or function generator)
+//  LED    -> PC13 (toggles every 100 blocks)
+//
+// Read the results with a debugger (e.g. `print blockMax` in gdb).
+
+#define SIGNAL_PIN  A1
+#define LED_PIN     C13
+
+#define SAMPLE_RATE 200000
+#define BLOCK_SIZE  256
+#define WINDOW      16
+
+// Two blocks, one being filled while the other is processed
+static uint16_t samples[2 * BLOCK_SIZE] __attribute__((aligned(4)));
+
+// Moving average over the stream, carried from block to block
+static MovingAverage average;
+static uint16_t history[WINDOW] __attribute__((aligned(4)));
+static uint16_t filtered[BLOCK_SIZE] __attribute__((aligned(4)));
+
+// Statistics of the last block, gaps in the samples so far, and the rates
+// actually achieved
+volatile uint16_t blockMin;
+volatile uint16_t blockMax;
+volatile uint16_t blockAverage;
+volatile uint16_t rawSpread;
+volatile uint16_t filteredSpread;
+volatile uint32_t blocks;
+volatile uint32_t gaps;
+volatile uint32_t sampleRate;
+volatile uint32_t maxSampleRate;
+
+// Difference between the largest and smallest sample of a block
+static uint16_t spread(const uint16_t *block, uint16_t length) {
+    uint16_t min = 0xFFFF;
+    uint16_t max = 0;
+
+    for(uint16_t i = 0; i < length; i++) {
+        if(block[i] < min) {
+            min = block[i];
+        }
+        if(block[i] > max) {
+            max = block[i];
+        }
+    }
+
+    return max - min;
+}
+
+static void blockReady(const uint16_t *block, uint16_t length, void *context) {
+    uint16_t min = 0xFFFF;
+    uint16_t max = 0;
+    uint32_t sum = 0;
+
+    for(uint16_t i = 0; i < length; i++) {
+        if(block[i] < min) {
+            min = block[i];
+        }
+        if(block[i] > max) {
+            max = block[i];
+        }
+        sum += block[i];
+    }
+
+    blockMin = min;
+    blockMax = max;
+    blockAverage = sum / length;
+
+    filterMovingAverage(&average, block, filtered, length);
+    rawSpread = max - min;
+    filteredSpread = spread(filtered, length);
+
+    blocks++;
+    gaps = adcGetOverruns();
+    if(blocks % 100 == 0) {
+        gpioToggleFast(LED_PIN);
+    }
+}
+
+int main(void) {
+    gpioInit(GPIOA);
+    gpioInit(GPIOC);
+    gpioPinMode(SIGNAL_PIN, ANALOG);
+    gpioPinMode(LED_PIN, OUTPUT);
+
+    adcInit();
+    filterMovingAverageInit(&average, history, WINDOW);
+
+    // 15 + 12 cycles at 21 MHz, about 780 kSPS at most
+    static const AdcChannel channels[] = { CHANNEL_1 };
+    adcSetSampleTime(CHANNEL_1, ADC_SAMPLE_15);
+    maxSampleRate = adcGetMaxSampleRate(channels, 1);
+
+    static const AdcStream stream = {
+        .channels = channels,
+        .count = 1,
+        .sampleRate = SAMPLE_RATE,
+        .trigger = ADC_TRIGGER_TIM2,
+        .buffer = samples,
+        .blockLength = BLOCK_SIZE,
+        .callback = blockReady,
+        .context = NULL,
+    };
+    sampleRate = adcStreamStart(&stream);
+
+    while(1) {
+        __asm__ volatile ("wfi");
+    }
+}
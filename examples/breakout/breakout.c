@@ -3,10 +3,10 @@
 #include <armory/adc.h>
 #include <armory/i2c.h>
 #include <armory/timing.h>
+#include <armory/sh1106.h>
 #include <stdint.h>
 
 #include "io.h"
-#include "sh1106.h"
 
 
 #define PADDLE_WIDTH  18
@@ -20,6 +20,9 @@
 #define BLOCK_WIDTH   11
 #define BLOCK_HEIGHT  4
 
+// Time between the start of two frames
+#define FRAME_TIME_US 30000
+
 static uint8_t blocks[BLOCK_COLS][BLOCK_ROWS];
 
 void drawBlocks() {
@@ -79,6 +82,9 @@ int main() {
     int8_t velY = -1;
 
     while(1) {
+        // Frames start at a fixed rate, however long the game logic takes
+        Deadline frame = timingDeadline(FRAME_TIME_US);
+
         readJoystick();
 
         paddlePX = paddleX;
@@ -193,8 +199,11 @@ int main() {
                 }
 
             }
-            // Wait for joystick press and recall main
-            while(gpioDigitalRead(JOY_SW));
+            // Sleep until the joystick is pressed, then recall main
+            joystickClicked = false;
+            while(!joystickClicked) {
+                __asm__ volatile ("wfi");
+            }
             for(int i = 0; i < 3; i++) {
                 gpioWrite(GREEN_LED, HIGH);
                 delay_ms(100);
@@ -218,8 +227,10 @@ int main() {
 
 
 
+        // Queues the frame and returns, it is sent while the next one is
+        // worked on. A frame still being sent is picked up next time.
         oledUpdate();
-        delay_ms(30);
+        while(!timingExpired(&frame));
     }
 
 }
@@ -2,6 +2,7 @@
 #include <armory/gpio.h>
 #include <armory/adc.h>
 #include <armory/pwm.h>
+#include <armory/exti.h>
 #include <stdint.h>
 #include "io.h"
 
@@ -9,21 +10,40 @@ volatile int16_t deltaX = 0;
 volatile int16_t deltaY = 0;
 volatile PinState joystickPressed = HIGH;
 
+// Latest joystick readings, kept up to date by the ADC scan
+static volatile uint16_t joyRaw[2];
+
+// Set on every debounced press, cleared by whoever waits for one
+volatile bool joystickClicked = false;
+
+static void joystickChanged(Pin pin, PinState level, void *context) {
+    joystickPressed = !level; // active low
+    if(joystickPressed) {
+        joystickClicked = true;
+    }
+}
+
 void ioInit(void) {
     gpioInitAll();
     adcInit();
 
     pwmInitPin(RED_LED);
-    gpioPinMode(GREEN_LED, OUTPUT);
     pwmInitPin(BLUE_LED);
 
-    gpioPinMode(JOY_X,  ANALOG);
-    gpioPinMode(JOY_Y,  ANALOG);
-    gpioPinMode(JOY_SW, INPUT);
+    static const PinConfig pins[] = {
+        { GREEN_LED, OUTPUT, PUSH_PULL, LOW_SPEED, NO_PULL, AF0 },
+        { JOY_X,     ANALOG, PUSH_PULL, LOW_SPEED, NO_PULL, AF0 },
+        { JOY_Y,     ANALOG, PUSH_PULL, LOW_SPEED, NO_PULL, AF0 },
+        { JOY_SW,    INPUT,  PUSH_PULL, LOW_SPEED, PULL_UP, AF0 },
+    };
+    gpioConfigure(pins, sizeof(pins) / sizeof(PinConfig));
+
+    extiAttach(JOY_SW, EXTI_BOTH, JOY_DEBOUNCE_US, joystickChanged, NULL);
 
-    gpioSetPull(JOY_X, NO_PULL);
-    gpioSetPull(JOY_Y, NO_PULL);
-    gpioSetPull(JOY_SW, PULL_UP);
+    // Both axes are converted continuously in the background
+    AdcChannel axes[2] = { gpioToAdcChannel(JOY_X), gpioToAdcChannel(JOY_Y) };
+    adcScanStop();
+    adcScanStart(axes, 2, joyRaw);
 }
 
 int16_t absVal(int16_t a) {
@@ -46,11 +66,9 @@ static int16_t scaleJoystick(int raw) {
 }
 
 void readJoystick(void) {
-    int rawX = adcReadPin(JOY_X);
-    int rawY = adcReadPin(JOY_Y);
+    int rawX = joyRaw[0];
+    int rawY = joyRaw[1];
 
     deltaX = scaleJoystick(rawX);
     deltaY = scaleJoystick(rawY);
-
-    joystickPressed = !gpioDigitalRead(JOY_SW); // active low
 }
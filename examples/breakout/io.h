@@ -3,6 +3,7 @@
 #define IO_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <armory/gpio.h>
 
 #define RED_LED     A8
@@ -19,9 +20,13 @@
 #define JOY_CENTER   2048
 #define JOY_OUTPUT_MAX 127
 
+// How long the joystick button has to settle before a change counts
+#define JOY_DEBOUNCE_US 10000
+
 extern volatile int16_t deltaX;
 extern volatile int16_t deltaY;
 extern volatile PinState joystickPressed;
+extern volatile bool joystickClicked;
 
 void ioInit(void);
 void readJoystick(void);
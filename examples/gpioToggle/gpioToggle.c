@@ -0,0 +1,70 @@
+#include <armory/gpio.h>
+#include <armory/timing.h>
+#include <stdint.h>
+
+// Measures the cycles per pin toggle of the out-of-line gpioWrite against
+// the inlined fast path in gpio.h, and a raw BSRR store for reference.
+//
+// Wiring:
+//  Scope -> PA5 (optional, shows the toggle rate)
+//  LED   -> PC13 (lights up once the results are ready)
+//
+// The results are left in the *Cycles variables below, read them out with a
+// debugger (e.g. `print fastCycles` in gdb). Build with
+// `make EXTRA_CFLAGS=-O2` as well to see the single store versions.
+
+#define TOGGLE_PIN A5
+#define LED_PIN    C13
+
+// Each loop runs this many high/low pairs
+#define TOGGLES 1000
+
+// Cycles per toggle, averaged over TOGGLES pairs
+volatile uint32_t writeCycles;
+volatile uint32_t fastCycles;
+volatile uint32_t toggleFastCycles;
+volatile uint32_t rawCycles;
+
+int main(void) {
+    timingInit();
+
+    gpioInit(GPIOA);
+    gpioInit(GPIOC);
+    gpioPinMode(TOGGLE_PIN, OUTPUT);
+    gpioPinMode(LED_PIN, OUTPUT);
+    gpioWrite(LED_PIN, HIGH);
+
+    uint32_t start = DWT_CYCCNT;
+    for(int i = 0; i < TOGGLES; i++) {
+        gpioWrite(TOGGLE_PIN, HIGH);
+        gpioWrite(TOGGLE_PIN, LOW);
+    }
+    writeCycles = (DWT_CYCCNT - start) / (2 * TOGGLES);
+
+    start = DWT_CYCCNT;
+    for(int i = 0; i < TOGGLES; i++) {
+        gpioSetFast(TOGGLE_PIN);
+        gpioClearFast(TOGGLE_PIN);
+    }
+    fastCycles = (DWT_CYCCNT - start) / (2 * TOGGLES);
+
+    start = DWT_CYCCNT;
+    for(int i = 0; i < TOGGLES; i++) {
+        gpioToggleFast(TOGGLE_PIN);
+        gpioToggleFast(TOGGLE_PIN);
+    }
+    toggleFastCycles = (DWT_CYCCNT - start) / (2 * TOGGLES);
+
+    // The lower bound, what the fast path compiles to with optimization
+    start = DWT_CYCCNT;
+    for(int i = 0; i < TOGGLES; i++) {
+        GPIOA->BSRR = PIN_MASK(5);
+        GPIOA->BSRR = PIN_RESET_MASK(5);
+    }
+    rawCycles = (DWT_CYCCNT - start) / (2 * TOGGLES);
+
+    // Results ready, onboard LED is active low
+    gpioWrite(LED_PIN, LOW);
+
+    while(1);
+}
@@ -0,0 +1,120 @@
+#include <armory/gpio.h>
+#include <armory/i2c.h>
+#include <armory/timing.h>
+#include <stdint.h>
+
+// Compares the CPU cost of one 129 byte I2C write (an SH1106 page) across
+// the polled, interrupt driven and DMA paths.
+//
+// Wiring:
+//  Any device that accepts long writes (e.g. an SH1106 OLED) on I2C1
+//  SCL -> PB6
+//  SDA -> PB7
+//  LED -> PC13 (lights up once the results are ready)
+//
+// The results are left in the *Result variables below, read them out with
+// a debugger (e.g. `print dmaResult` in gdb).
+
+#define DEV_ADDR   0x3C
+#define LED_PIN    C13
+#define PAGE_SIZE  129
+
+// Number of idle loop iterations used to calibrate the idle loop
+#define CALIBRATION_LOOPS 1000
+
+typedef struct {
+    // Cycles from the start of the transfer until it has completed
+    uint32_t totalCycles;
+    // Part of totalCycles the CPU could not spend on other work
+    uint32_t cpuCycles;
+} BenchResult;
+
+volatile BenchResult polledResult;
+volatile BenchResult interruptResult;
+volatile BenchResult dmaResult;
+
+static uint8_t page[PAGE_SIZE];
+
+// Stand-in for application work, counts iterations until the transfer is done
+static uint32_t idle(volatile const I2CResult *result, uint32_t limit) {
+    uint32_t n = 0;
+    while(*result == I2C_BUSY && n < limit) {
+        n++;
+    }
+    return n;
+}
+
+// Cycles taken by CALIBRATION_LOOPS iterations of the idle loop
+static uint32_t calibrateIdle(void) {
+    volatile I2CResult never = I2C_BUSY;
+
+    uint32_t start = DWT_CYCCNT;
+    idle(&never, CALIBRATION_LOOPS);
+    return DWT_CYCCNT - start;
+}
+
+// The old hand-rolled write, busy-waiting on every flag
+static void benchPolled(void) {
+    uint32_t start = DWT_CYCCNT;
+
+    i2cStart(I2C1);
+    if(i2cSendAddr(I2C1, DEV_ADDR, false) == I2C_OK) {
+        for(int i = 0; i < PAGE_SIZE; i++) {
+            if(i2cSendData(I2C1, page[i]) != I2C_OK) {
+                break;
+            }
+        }
+    }
+    i2cStop(I2C1);
+
+    polledResult.totalCycles = DWT_CYCCNT - start;
+    polledResult.cpuCycles = polledResult.totalCycles;
+}
+
+static void benchAsync(volatile BenchResult *result, uint32_t idleCycles) {
+    I2CMessage msg = { DEV_ADDR, 0, PAGE_SIZE, page };
+    I2CTransaction txn = {
+        .msgs = &msg,
+        .count = 1
+    };
+
+    uint32_t start = DWT_CYCCNT;
+    i2cSubmit(I2C1, &txn);
+    uint32_t loops = idle(&txn.result, 0xFFFFFFFF);
+    result->totalCycles = DWT_CYCCNT - start;
+
+    // Everything not spent in the idle loop went to the driver
+    result->cpuCycles = result->totalCycles - (loops * idleCycles) / CALIBRATION_LOOPS;
+}
+
+int main(void) {
+    // Also enables the DWT cycle counter
+    delay_ms(30);
+
+    gpioInit(GPIOC);
+    gpioPinMode(LED_PIN, OUTPUT);
+    gpioWrite(LED_PIN, HIGH);
+
+    i2cInit(I2C1);
+
+    // Data byte control prefix followed by a pattern
+    page[0] = 0x40;
+    for(int i = 1; i < PAGE_SIZE; i++) {
+        page[i] = (uint8_t)i;
+    }
+
+    uint32_t idleCycles = calibrateIdle();
+
+    benchPolled();
+
+    i2cEnableDma(I2C1, false);
+    benchAsync(&interruptResult, idleCycles);
+
+    i2cEnableDma(I2C1, true);
+    benchAsync(&dmaResult, idleCycles);
+
+    // Results ready, onboard LED is active low
+    gpioWrite(LED_PIN, LOW);
+
+    while(1);
+}
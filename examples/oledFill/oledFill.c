@@ -0,0 +1,80 @@
+#include <armory/gpio.h>
+#include <armory/sh1106.h>
+#include <armory/timing.h>
+#include <stdint.h>
+
+// Compares the cycles taken to fill rectangles with the span based
+// oledDrawRectangle against the old pixel by pixel version.
+//
+// Only the framebuffer is touched, no display needs to be connected.
+//
+// Wiring:
+//  LED -> PC13 (lights up once the results are ready)
+//
+// The results are left in fillResults below, read them out with a debugger
+// (e.g. `print fillResults` in gdb).
+
+#define LED_PIN C13
+
+// Each rectangle is set then cleared this many times
+#define ITERATIONS 16
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+
+    // Average cycles per filled rectangle
+    uint32_t pixelCycles;
+    uint32_t spanCycles;
+} FillResult;
+
+// Shapes from the breakout example, plus a page-crossing box and the full screen
+volatile FillResult fillResults[] = {
+    {  20, 30,   1,  1 },  // Ball
+    {  12,  5,  11,  4 },  // Block
+    {  55, 57,  18,  3 },  // Paddle
+    {  30, 13,  40, 20 },  // Box over three pages
+    {   0,  0, 128, 64 },  // Whole screen
+};
+
+// The old implementation, one oledDrawPixel call per pixel
+static void drawRectanglePixels(uint8_t x, uint8_t y, uint8_t w, uint8_t h, bool on) {
+    for(int dx = 0; dx < w; dx++) {
+        for(int dy = 0; dy < h; dy++) {
+            oledDrawPixel(x + dx, y + dy, on);
+        }
+    }
+}
+
+static uint32_t bench(void (*draw)(uint8_t, uint8_t, uint8_t, uint8_t, bool),
+        volatile FillResult *r) {
+    uint32_t start = DWT_CYCCNT;
+
+    // Alternate so every call has pixels to change
+    for(int i = 0; i < ITERATIONS; i++) {
+        draw(r->x, r->y, r->w, r->h, true);
+        draw(r->x, r->y, r->w, r->h, false);
+    }
+
+    return (DWT_CYCCNT - start) / (2 * ITERATIONS);
+}
+
+int main(void) {
+    timingInit();
+
+    gpioInit(GPIOC);
+    gpioPinMode(LED_PIN, OUTPUT);
+    gpioWrite(LED_PIN, HIGH);
+
+    for(int i = 0; i < sizeof(fillResults) / sizeof(FillResult); i++) {
+        fillResults[i].pixelCycles = bench(drawRectanglePixels, &fillResults[i]);
+        fillResults[i].spanCycles = bench(oledDrawRectangle, &fillResults[i]);
+    }
+
+    // Results ready, onboard LED is active low
+    gpioWrite(LED_PIN, LOW);
+
+    while(1);
+}
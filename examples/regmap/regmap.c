@@ -0,0 +1,125 @@
+#include <armory/gpio.h>
+#include <armory/i2c.h>
+#include <armory/regmap.h>
+#include <armory/timing.h>
+#include <stdint.h>
+
+// Configures an MPU-6050 through a register cache and compares the cost of
+// the combined flush against writing the same registers one at a time. The
+// configuration is then read back from the device to check the cache.
+//
+// Wiring:
+//  MPU-6050 on I2C1 (AD0 low, address 0x68)
+//  SCL -> PB6
+//  SDA -> PB7
+//  LED -> PC13 (lights up once the results are ready)
+//
+// The results are left in the variables below, read them out with a
+// debugger (e.g. `print flushCycles` in gdb).
+
+#define DEV_ADDR    0x68
+#define LED_PIN     C13
+
+// Cached block, SMPLRT_DIV up to INT_STATUS
+#define REG_SMPLRT_DIV   0x19
+#define REG_CONFIG       0x1A
+#define REG_GYRO_CONFIG  0x1B
+#define REG_ACCEL_CONFIG 0x1C
+#define REG_INT_PIN_CFG  0x37
+#define REG_INT_ENABLE   0x38
+#define REG_INT_STATUS   0x3A // Cleared by reading it
+#define REG_COUNT        (REG_INT_STATUS - REG_SMPLRT_DIV + 1)
+
+// Outside the cached block, written straight through
+#define REG_PWR_MGMT_1   0x6B
+
+typedef struct {
+    uint8_t reg;
+    uint8_t value;
+} RegValue;
+
+// 1 kHz sample rate, 44 Hz low pass, +-500 dps, +-8 g, data ready interrupt
+static const RegValue config[] = {
+    { REG_SMPLRT_DIV,   0x00 },
+    { REG_CONFIG,       0x03 },
+    { REG_GYRO_CONFIG,  0x08 },
+    { REG_ACCEL_CONFIG, 0x10 },
+    { REG_INT_PIN_CFG,  0x10 },
+    { REG_INT_ENABLE,   0x01 },
+};
+
+#define CONFIG_COUNT (sizeof(config) / sizeof(RegValue))
+
+// Cycles of each approach, and the registers that did not read back right
+volatile uint32_t flushCycles;
+volatile uint32_t directCycles;
+volatile uint32_t cachedReadCycles;
+volatile uint32_t mismatches;
+volatile uint8_t intStatus;
+volatile I2CResult lastResult;
+
+static uint8_t cache[REG_COUNT];
+static uint8_t state[REG_COUNT];
+
+int main(void) {
+    // Also enables the DWT cycle counter
+    delay_ms(100);
+
+    gpioInit(GPIOC);
+    gpioPinMode(LED_PIN, OUTPUT);
+    gpioWrite(LED_PIN, HIGH);
+
+    i2cInit(I2C1);
+
+    Regmap map;
+    regmapInit(&map, I2C1, DEV_ADDR, REG_SMPLRT_DIV, REG_COUNT, cache, state);
+    regmapSetVolatile(&map, REG_INT_STATUS, true);
+
+    // Wake the device up, PWR_MGMT_1 is not cached so this goes out now
+    lastResult = regmapWrite(&map, REG_PWR_MGMT_1, 0x01);
+    delay_ms(10);
+
+    // Load the current values, INT_STATUS is skipped so no flags are lost
+    lastResult = regmapRefresh(&map);
+
+    // Only registers that change are sent, in as few bursts as possible
+    for(int i = 0; i < CONFIG_COUNT; i++) {
+        regmapWrite(&map, config[i].reg, config[i].value);
+    }
+    uint32_t start = DWT_CYCCNT;
+    lastResult = regmapFlush(&map);
+    flushCycles = DWT_CYCCNT - start;
+
+    // The same configuration, one transaction per register
+    start = DWT_CYCCNT;
+    for(int i = 0; i < CONFIG_COUNT; i++) {
+        i2cWriteByte(I2C1, DEV_ADDR, config[i].reg, config[i].value);
+    }
+    directCycles = DWT_CYCCNT - start;
+
+    // Cached reads never touch the bus
+    uint8_t value;
+    start = DWT_CYCCNT;
+    for(int i = 0; i < CONFIG_COUNT; i++) {
+        regmapRead(&map, config[i].reg, &value);
+    }
+    cachedReadCycles = DWT_CYCCNT - start;
+
+    // Read everything back from the device and compare
+    regmapInvalidate(&map);
+    lastResult = regmapRefresh(&map);
+    for(int i = 0; i < CONFIG_COUNT; i++) {
+        if(regmapRead(&map, config[i].reg, &value) != I2C_OK || value != config[i].value) {
+            mismatches++;
+        }
+    }
+
+    // Volatile registers always go to the device
+    regmapRead(&map, REG_INT_STATUS, &value);
+    intStatus = value;
+
+    // Results ready, onboard LED is active low
+    gpioWrite(LED_PIN, LOW);
+
+    while(1);
+}
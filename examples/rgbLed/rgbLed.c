@@ -1,6 +1,7 @@
 #include "armory/gpio.h"
 #include "armory/adc.h"
 #include "armory/pwm.h"
+#include "armory/exti.h"
 #define RED_LED B0
 #define GREEN_LED B1
 #define BLUE_LED A8
@@ -8,15 +9,31 @@
 #define BUTTON_PIN A0
 #define POT_PIN A1
 
+// How long the button has to stay pressed before it counts
+#define BUTTON_DEBOUNCE_US 20000
+
 #define GPIOC_MODER  (*(volatile unsigned int*)0x40020800)
 #define GPIOC_ODR    (*(volatile unsigned int*)0x40020814)
 
+// Keep track of mode of color picker:
+// 0 -> Display color
+// 1 -> Set Red
+// 2 -> Set Green
+// 3 -> Set Blue
+static volatile uint8_t mode = 1;
+
+// Runs once per debounced press, button is active low
+static void buttonPressed(Pin pin, PinState level, void *context) {
+    mode = (mode + 1) % 4;
+}
+
 int main(void) {
     gpioInitAll(); 
     adcInit();
 
     gpioPinMode(BUTTON_PIN, INPUT);
     gpioSetPull(BUTTON_PIN, PULL_UP);
+    extiAttach(BUTTON_PIN, EXTI_FALLING, BUTTON_DEBOUNCE_US, buttonPressed, NULL);
 
     gpioPinMode(POT_PIN, ANALOG);
     gpioSetPull(POT_PIN, NO_PULL);
@@ -29,18 +46,9 @@ int main(void) {
     uint8_t greenBrightness = 51;
     uint8_t blueBrightness  = 255;
 
-    // Keep track of mode of color picker:
-    // 0 -> Display color
-    // 1 -> Set Red
-    // 2 -> Set Green
-    // 3 -> Set Blue
-    uint8_t mode = 1;
-    
-    // Software debounce button (kind of)
-    uint16_t buttonWait = 1000;
     while(1) {
         uint16_t potValue = adcReadPin(POT_PIN); // 0–4095
-        if(potValue < 24) {
+        if(potValue == ADC_READ_ERROR || potValue < 24) {
             potValue = 0;
         }
         uint8_t scaledR = (redBrightness   * potValue) / 4095;
@@ -67,16 +75,6 @@ int main(void) {
             pwmWrite(GREEN_LED, 0);
             pwmWrite(BLUE_LED,  blueBrightness);
         }
-
-        // Mode switch with software debounce
-        if (!gpioDigitalRead(BUTTON_PIN) && buttonWait > 2000) {
-            mode = (mode + 1) % 4;
-            buttonWait = 0;
-        }
-
-        if (buttonWait <= 2000) {
-            buttonWait++;
-        }
     }
 }
 
@@ -0,0 +1,81 @@
+#include <armory/gpio.h>
+#include <armory/waveform.h>
+#include <stdint.h>
+
+// Drives a unipolar stepper motor through a ULN2003 style driver with the
+// waveform engine. The half-step sequence is played in a loop by TIM1 and
+// DMA2, so the CPU only wakes up once per sequence to blink the LED.
+//
+// Wiring:
+//  IN1 -> PB12
+//  IN2 -> PB13
+//  IN3 -> PB14
+//  IN4 -> PB15
+//  LED -> PC13 (toggles every 64 passes through the sequence)
+//
+// A scope on PB12-PB15 shows the sequence. The engine itself keeps up at
+// MHz rates, but the callback runs at every half and end of the sequence,
+// STEP_RATE / 4 times a second. Remove the waveformSetCallback call before
+// raising STEP_RATE much beyond a few kHz.
+
+#define LED_PIN C13
+
+// Half steps per second
+#define STEP_RATE 800
+
+// Coils are on the top four pins of port B
+#define COIL_SHIFT 12
+#define COIL_MASK  (0x0F << COIL_SHIFT)
+
+// Half-step coil pattern, one or two coils on at a time
+static const uint16_t halfSteps[] = {
+    0b0001, 0b0011, 0b0010, 0b0110, 0b0100, 0b1100, 0b1000, 0b1001
+};
+
+#define STEP_COUNT (sizeof(halfSteps) / sizeof(halfSteps[0]))
+
+// Played by DMA straight from SRAM
+static uint32_t samples[STEP_COUNT];
+
+// Sequences played so far
+volatile uint32_t sequences;
+
+static void sequenceDone(WaveformEvent event, void *context) {
+    if(event != WAVEFORM_END) {
+        return;
+    }
+
+    sequences++;
+    if((sequences & 0x3F) == 0) {
+        gpioToggleFast(LED_PIN);
+    }
+}
+
+int main(void) {
+    gpioInit(GPIOB);
+    gpioInit(GPIOC);
+
+    static const PinConfig pins[] = {
+        { B12,     OUTPUT, PUSH_PULL, HIGH_SPEED, NO_PULL, AF0 },
+        { B13,     OUTPUT, PUSH_PULL, HIGH_SPEED, NO_PULL, AF0 },
+        { B14,     OUTPUT, PUSH_PULL, HIGH_SPEED, NO_PULL, AF0 },
+        { B15,     OUTPUT, PUSH_PULL, HIGH_SPEED, NO_PULL, AF0 },
+        { LED_PIN, OUTPUT, PUSH_PULL, LOW_SPEED,  NO_PULL, AF0 },
+    };
+    gpioConfigure(pins, sizeof(pins) / sizeof(PinConfig));
+
+    uint16_t values[STEP_COUNT];
+    for(int i = 0; i < STEP_COUNT; i++) {
+        values[i] = halfSteps[i] << COIL_SHIFT;
+    }
+    waveformEncode(samples, values, STEP_COUNT, COIL_MASK);
+
+    waveformInit(STEP_RATE);
+    waveformSetCallback(sequenceDone, NULL);
+    waveformStart(GPIOB, samples, STEP_COUNT, WAVEFORM_LOOP);
+
+    // Nothing left for the CPU to do
+    while(1) {
+        __asm__ volatile ("wfi");
+    }
+}
@@ -3,16 +3,32 @@
 #define ADC_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "armory/gpio.h"
 
+// ADC CR1 Register bit definitions
+#define ADC_CR1_JEOCIE      (1U << 7)  // Injected end of conversion interrupt
+#define ADC_CR1_SCAN        (1U << 8)  // Scan mode
+#define ADC_CR1_OVRIE       (1U << 26) // Overrun interrupt
+#define ADC_CR1_RES_Pos     24         // Resolution
+#define ADC_CR1_RES         (0x3U << ADC_CR1_RES_Pos)
+
 // ADC CR2 Register bit definitions
 #define ADC_CR2_ADON         (1U << 0)  // ADC ON/OFF
 #define ADC_CR2_CONT        (1U << 1)  // Continuous conversion mode
 #define ADC_CR2_DMA         (1U << 8)  // DMA mode
-#define ADC_CR2_EOCS        (1U << 9)  // End of conversion interrupt
-#define ADC_CR2_EXTEN       (1U << 10) // External trigger enable
-#define ADC_CR2_EXTSEL      (1U << 11) // External trigger selection
+#define ADC_CR2_DDS         (1U << 9)  // Keep issuing DMA requests
+#define ADC_CR2_EOCS        (1U << 10) // End of conversion selection
+#define ADC_CR2_ALIGN       (1U << 11) // Data alignment
+#define ADC_CR2_EXTSEL_Pos  24         // External trigger selection
+#define ADC_CR2_EXTSEL      (0xFU << ADC_CR2_EXTSEL_Pos)
+#define ADC_CR2_EXTEN_Pos   28         // External trigger enable
+#define ADC_CR2_EXTEN       (0x3U << ADC_CR2_EXTEN_Pos)
+#define ADC_CR2_JEXTSEL_Pos 16         // Injected external trigger selection
+#define ADC_CR2_JEXTSEL     (0xFU << ADC_CR2_JEXTSEL_Pos)
+#define ADC_CR2_JEXTEN_Pos  20         // Injected external trigger enable
+#define ADC_CR2_JEXTEN      (0x3U << ADC_CR2_JEXTEN_Pos)
 #define ADC_CR2_JSWSTART    (1U << 22) // Start conversion for injected channels
 #define ADC_CR2_SWSTART     (1U << 30) // Start conversion for regular channels
 
@@ -24,6 +40,50 @@
 #define ADC_SR_STRT        (1U << 4)  // Regular channel start flag
 #define ADC_SR_OVR         (1U << 5)  // Overrun flag
 
+// ADC SMPR1/SMPR2 sample time fields are 3 bits per channel, channels
+// 0-9 in SMPR2 and 10-18 in SMPR1
+#define ADC_SMPR_BITS      3
+#define ADC_SMPR_MASK      0x7U
+
+// ADC CCR prescaler field, ADCCLK = PCLK2 / (2 * (ADCPRE + 1))
+#define ADC_CCR_ADCPRE_Pos 16
+#define ADC_CCR_ADCPRE     (0x3U << ADC_CCR_ADCPRE_Pos)
+
+// ADC SQR1 Register bit definitions
+#define ADC_SQR1_L_Pos     20         // Regular sequence length - 1
+
+// ADC JSQR Register bit definitions
+#define ADC_JSQR_JL_Pos    20         // Injected sequence length - 1
+
+// Most channels in the injected group
+#define ADC_MAX_INJECTED   4
+
+// Returned by the read functions when there is no result. Never a valid
+// conversion, results are at most 12 bits.
+#define ADC_READ_ERROR     0xFFFF
+
+// Longest a single conversion may take before a read gives up, e.g. when
+// the ADC clock is stopped. A 480 cycle sample at 21 MHz takes 24 us.
+#define ADC_TIMEOUT_US     100
+
+// ADC1 requests are served by DMA2 stream 0, channel 0
+#define ADC_DMA_STREAM     0
+#define ADC_DMA_CHANNEL    0
+
+// Most channels in a regular sequence
+#define ADC_MAX_SCAN       16
+
+// Priority of the DMA2 stream 0 interrupt while streaming
+#ifndef ADC_IRQ_PRIORITY
+#define ADC_IRQ_PRIORITY   3
+#endif
+
+// Priority of the ADC interrupt: injected end of conversion, high for a
+// fixed latency in control loops, and overrun recovery
+#ifndef ADC_INJECTED_IRQ_PRIORITY
+#define ADC_INJECTED_IRQ_PRIORITY 1
+#endif
+
 // ADC Common abse address
 #define ADC_COMMON_BASE 0x40012300
 #define ADC_CCR (*(volatile uint32_t *)(ADC_COMMON_BASE + 0x04))
@@ -75,14 +135,80 @@ typedef enum {
     ADC_INVALID = 0xFF
 } AdcChannel;
 
+// Typedef for the sampling time of a channel, in ADC clock cycles
+typedef enum {
+    ADC_SAMPLE_3   = 0,
+    ADC_SAMPLE_15  = 1,
+    ADC_SAMPLE_28  = 2,
+    ADC_SAMPLE_56  = 3,
+    ADC_SAMPLE_84  = 4,
+    ADC_SAMPLE_112 = 5,
+    ADC_SAMPLE_144 = 6,
+    ADC_SAMPLE_480 = 7
+} AdcSampleTime;
+
+// Typedef for the conversion resolution, results stay right aligned
+typedef enum {
+    ADC_RESOLUTION_12 = 0,
+    ADC_RESOLUTION_10 = 1,
+    ADC_RESOLUTION_8  = 2,
+    ADC_RESOLUTION_6  = 3
+} AdcResolution;
+
+// Typedef for the timers that can pace conversions, by their TRGO
+// output (EXTSEL value). TIM1 and TIM5 are taken by the waveform engine
+// and EXTI debouncing.
+typedef enum {
+    ADC_TRIGGER_TIM2 = 0b0110,
+    ADC_TRIGGER_TIM3 = 0b1000
+} AdcTrigger;
+
+// Typedef for what starts the injected group, by JEXTSEL value. Timers
+// are set up by the caller, e.g. TRGO on update or a compare in the middle
+// of a PWM period.
+typedef enum {
+    ADC_INJECTED_TIM1_CC4  = 0b0000,
+    ADC_INJECTED_TIM1_TRGO = 0b0001,
+    ADC_INJECTED_TIM2_CC1  = 0b0010,
+    ADC_INJECTED_TIM2_TRGO = 0b0011,
+    ADC_INJECTED_TIM3_CC2  = 0b0100,
+    ADC_INJECTED_TIM3_CC4  = 0b0101,
+    ADC_INJECTED_TIM4_CC1  = 0b0110,
+    ADC_INJECTED_TIM4_CC2  = 0b0111,
+    ADC_INJECTED_TIM4_CC3  = 0b1000,
+    ADC_INJECTED_TIM4_TRGO = 0b1001,
+    ADC_INJECTED_SOFTWARE  = 0xFF   // Started with adcInjectedStart
+} AdcInjectedTrigger;
+
+// Called from the ADC interrupt with the results of the injected group,
+// results[i] belongs to the i-th channel passed to adcInjectedInit
+typedef void (*AdcInjectedCallback)(const uint16_t results[], uint8_t count, void *context);
+
+// Called from interrupt context with a block of samples that has just been
+// filled. The block stays untouched for as long as the other one takes to
+// fill.
+typedef void (*AdcBlockCallback)(const uint16_t *block, uint16_t length, void *context);
+
+// Description of a timer-paced stream of conversions
+typedef struct {
+    const AdcChannel *channels; // Channels converted on each trigger
+    uint8_t count;              // Number of channels (1 - ADC_MAX_SCAN)
+    uint32_t sampleRate;        // Triggers per second
+    AdcTrigger trigger;         // Timer that paces the conversions
+    uint16_t *buffer;           // Two blocks of blockLength samples
+    uint16_t blockLength;       // Samples per block, a multiple of count
+    AdcBlockCallback callback;  // Called as each block fills
+    void *context;              // User pointer passed to the callback
+} AdcStream;
+
 // Define ADC1 at base offset of ADC1
 #define ADC1 ((ADC_TypeDef *)(ADC1_BASE))
 
 /**
  * @brief Initializes ADC1 on the microcontroller.
  *
- * Enables ADC1 clock, sets the prescaler, and configures the sample time
- * for ADC1.
+ * Enables ADC1 clock, sets the prescaler (21 MHz ADC clock at 84 MHz), 12
+ * bit resolution and the longest sample time (480 cycles) on every channel.
  *
  * @note This must be called before calling any other ADC functions.
  */
@@ -99,18 +225,223 @@ AdcChannel gpioToAdcChannel(Pin pin);
 /**
  * @brief Reads an analog value from a given AdcChannel.
  *
- * @return The value read from the channel (0 - 4095)
+ * While a scan is running, the latest scan result is returned instead of
+ * starting a conversion. Other channels, and any channel while streaming,
+ * are read with a one-off injected conversion as long as the injected
+ * group is not set up.
+ *
+ * @return The value read from the channel (0 - 4095 at 12 bits), or
+ *         ADC_READ_ERROR if the channel is invalid, the ADC is busy and the
+ *         channel can't be read, or the conversion timed out.
  */
 uint16_t adcReadChannel(AdcChannel channel);
 
+/**
+ * @brief Reads an analog value from a given AdcChannel, reporting failure.
+ *
+ * Works like adcReadChannel, with the result kept apart from the status.
+ *
+ * @param channel The channel to read.
+ * @param value Where to store the value read (0 - 4095 at 12 bits).
+ *
+ * @return False if the channel is invalid, the ADC is busy and the channel
+ *         can't be read, or the conversion took longer than ADC_TIMEOUT_US.
+ *         value is left alone then.
+ */
+bool adcTryReadChannel(AdcChannel channel, uint16_t *value);
+
 /**
  * @brief Reads an analog value from a supported analog pin.
  *
- * Converts the analog value on the given pin to a 12-bit digital value
- * values 0 - 4095.
+ * Converts the analog value on the given pin to a digital value at the
+ * resolution set with adcSetResolution, 12 bits by default.
  *
- * @return The value read from the pin (0 - 4095)
+ * @return The value read from the pin (0 - 4095 at 12 bits), or
+ *         ADC_READ_ERROR if it can't be read, see adcReadChannel.
  */
 uint16_t adcReadPin(Pin pin);
 
+/**
+ * @brief Starts converting a group of channels over and over.
+ *
+ * Programs the channels into SQR1-SQR3 and runs ADC1 in continuous scan
+ * mode. DMA2 writes each result to its slot in a circular buffer, so the
+ * latest value of every channel is always in RAM without any CPU time.
+ *
+ * @param channels The channels to convert, in order. A channel may appear
+ *                 more than once.
+ * @param count Number of channels (1 - ADC_MAX_SCAN).
+ * @param results Buffer of count values, results[i] belongs to
+ *                channels[i]. Must stay valid until adcScanStop.
+ *
+ * @return False if the ADC is already scanning or the arguments are invalid.
+ *
+ * @note If the DMA ever falls behind, the overrun interrupt restarts the
+ *       scan from results[0] and counts it in adcGetOverruns.
+ */
+bool adcScanStart(const AdcChannel channels[], uint8_t count, volatile uint16_t *results);
+
+/**
+ * @brief Stops a running scan and powers ADC1 down.
+ *
+ * The results buffer keeps the last values written to it.
+ */
+void adcScanStop(void);
+
+/**
+ * @brief Checks whether a scan is running.
+ *
+ * @return True between adcScanStart and adcScanStop.
+ */
+bool adcIsScanning(void);
+
+/**
+ * @brief Gets the number of overruns of the running scan or stream.
+ *
+ * An overrun is a conversion that finished before DMA2 had taken the one
+ * before it, e.g. because higher priority streams held DMA2 up. ADC1 then
+ * stops its DMA requests, so the ADC interrupt restarts the transfer from
+ * the start of the buffer. Each overrun is one gap in the samples.
+ *
+ * @return Overruns since the last adcScanStart or adcStreamStart.
+ */
+uint32_t adcGetOverruns(void);
+
+/**
+ * @brief Sets how long a channel's input is sampled before conversion.
+ *
+ * Longer times suit sources with a higher impedance, shorter ones allow
+ * higher sample rates. Applies to every group the channel is used in.
+ *
+ * @param channel The channel to set.
+ * @param time The sample time.
+ */
+void adcSetSampleTime(AdcChannel channel, AdcSampleTime time);
+
+/**
+ * @brief Sets the resolution of every conversion.
+ *
+ * Each bit less saves one ADC clock cycle per conversion.
+ *
+ * @param resolution The new resolution.
+ */
+void adcSetResolution(AdcResolution resolution);
+
+/**
+ * @brief Gets the ADC clock frequency.
+ *
+ * @return ADCCLK in Hz.
+ */
+uint32_t adcGetClockFreq(void);
+
+/**
+ * @brief Gets the time one conversion of a channel takes.
+ *
+ * The sample time of the channel plus one cycle per bit of resolution.
+ *
+ * @param channel The channel to check.
+ *
+ * @return The conversion time in ADC clock cycles, or 0 for an invalid
+ *         channel.
+ */
+uint32_t adcGetConversionCycles(AdcChannel channel);
+
+/**
+ * @brief Gets the time one conversion of a channel takes.
+ *
+ * @param channel The channel to check.
+ *
+ * @return The conversion time in nanoseconds, or 0 for an invalid channel.
+ */
+uint32_t adcGetConversionTimeNs(AdcChannel channel);
+
+/**
+ * @brief Gets the highest rate a group of channels can be converted at.
+ *
+ * @param channels The channels converted one after the other.
+ * @param count Number of channels.
+ *
+ * @return Passes over all the channels per second.
+ */
+uint32_t adcGetMaxSampleRate(const AdcChannel channels[], uint8_t count);
+
+/**
+ * @brief Starts sampling at a fixed rate into a double buffer.
+ *
+ * The trigger timer's update event (TRGO) starts one conversion of every
+ * channel through EXTEN/EXTSEL, so samples are evenly spaced whatever the
+ * CPU is doing. DMA2 fills the buffer in a circle: the callback gets the
+ * first block at the half-transfer interrupt and the second at transfer
+ * complete, and can process one while the other fills, without gaps.
+ *
+ * Samples of the channels are interleaved in each block, in channel order.
+ * The conversion time of all channels must fit in one trigger period, see
+ * adcGetMaxSampleRate. Hundreds of kSPS need short sample times, set with
+ * adcSetSampleTime.
+ *
+ * A sample the DMA could not take in time is an overrun. The ADC interrupt
+ * then restarts the stream at the first block from the next trigger and
+ * counts the gap in adcGetOverruns.
+ *
+ * @note The trigger timer can't be used for PWM at the same time.
+ *
+ * @param stream Pointer to the stream description, which must stay valid
+ *               until adcStreamStop.
+ *
+ * @return The sample rate achieved with the timer clock, or 0 if the ADC is
+ *         busy, the stream is invalid or its channels can't be converted
+ *         at that rate.
+ */
+uint32_t adcStreamStart(const AdcStream *stream);
+
+/**
+ * @brief Stops a running stream, its timer and ADC1.
+ */
+void adcStreamStop(void);
+
+/**
+ * @brief Sets up the injected group of ADC1.
+ *
+ * Injected conversions interrupt whatever the regular group is doing, a
+ * scan or a stream, and it carries on afterwards. The results land in
+ * JDR1-4 and are handed to the callback from the JEOC interrupt, which
+ * runs at ADC_INJECTED_IRQ_PRIORITY. This suits the few channels that need
+ * a low, fixed latency, e.g. current sense at a point of a PWM period.
+ *
+ * @param channels The channels to convert, in order.
+ * @param count Number of channels (1 - ADC_MAX_INJECTED).
+ * @param trigger Timer event that starts the group on its rising edge, or
+ *                ADC_INJECTED_SOFTWARE.
+ * @param callback Function to call with the results, or NULL to only read
+ *                 them with adcInjectedRead.
+ * @param context User pointer passed to the callback.
+ *
+ * @return False if the arguments are invalid.
+ */
+bool adcInjectedInit(const AdcChannel channels[], uint8_t count, AdcInjectedTrigger trigger,
+        AdcInjectedCallback callback, void *context);
+
+/**
+ * @brief Starts one conversion of a software triggered injected group.
+ *
+ * @return False if the group isn't set up with ADC_INJECTED_SOFTWARE.
+ */
+bool adcInjectedStart(void);
+
+/**
+ * @brief Reads the latest result of one injected channel.
+ *
+ * @param index Position of the channel in the group (0 - count - 1).
+ *
+ * @return The last converted value, or ADC_READ_ERROR for an invalid index.
+ */
+uint16_t adcInjectedRead(uint8_t index);
+
+/**
+ * @brief Stops the injected group and disconnects its trigger.
+ *
+ * ADC1 is powered down unless the regular group is running.
+ */
+void adcInjectedStop(void);
+
 #endif // !ADC_H
@@ -0,0 +1,91 @@
+#ifndef BITBAND_H
+#define BITBAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The Cortex-M4 maps every bit of the first 1 MB of SRAM and of the
+// peripheral region to its own word in an alias region. A store to the
+// alias word changes just that bit in one locked bus transaction, so it
+// can't race an interrupt touching other bits of the same register.
+#define BITBAND_SRAM_BASE    0x20000000
+#define BITBAND_SRAM_ALIAS   0x22000000
+#define BITBAND_PERIPH_BASE  0x40000000
+#define BITBAND_PERIPH_ALIAS 0x42000000
+
+// Size of each bit-band region
+#define BITBAND_REGION_SIZE  0x00100000
+
+// Bit number of a single bit mask, folds to a constant for defined masks
+#define BITBAND_BIT(mask) ((uint8_t)__builtin_ctz(mask))
+
+// Forced inline so constant arguments fold to a single store
+#define BITBAND_INLINE static inline __attribute__((always_inline))
+
+/**
+ * @brief Gets the alias word of one bit in SRAM or a peripheral register.
+ *
+ * Both regions have their alias 32 MB above the base, with each byte of the
+ * region spread over 32 alias words.
+ *
+ * @param addr Address inside the first 1 MB of SRAM (0x20000000) or the
+ *             peripheral region (0x40000000). AHB2 peripherals such as
+ *             USB OTG are outside it.
+ * @param bit The bit number in the word at addr (0 - 31).
+ *
+ * @return Pointer to the alias word.
+ */
+BITBAND_INLINE volatile uint32_t *bitbandAlias(volatile void *addr, uint8_t bit) {
+    uint32_t a = (uint32_t)addr;
+    return (volatile uint32_t *)((a & 0xF0000000) + 0x02000000
+            + ((a & (BITBAND_REGION_SIZE - 1)) << 5) + ((uint32_t)bit << 2));
+}
+
+/**
+ * @brief Sets one bit of a register or SRAM word with a single store.
+ *
+ * @note Don't use on status registers with write-0-to-clear flags. The bus
+ *       still reads and writes back the whole register, and clears any flag
+ *       set in between. Write the inverted mask to those directly.
+ *
+ * @param reg Pointer to the register.
+ * @param bit The bit number to set.
+ */
+BITBAND_INLINE void bitbandSet(volatile uint32_t *reg, uint8_t bit) {
+    *bitbandAlias(reg, bit) = 1;
+}
+
+/**
+ * @brief Clears one bit of a register or SRAM word with a single store.
+ *
+ * @param reg Pointer to the register.
+ * @param bit The bit number to clear.
+ */
+BITBAND_INLINE void bitbandClear(volatile uint32_t *reg, uint8_t bit) {
+    *bitbandAlias(reg, bit) = 0;
+}
+
+/**
+ * @brief Writes one bit of a register or SRAM word with a single store.
+ *
+ * @param reg Pointer to the register.
+ * @param bit The bit number to write.
+ * @param value The new value of the bit.
+ */
+BITBAND_INLINE void bitbandWrite(volatile uint32_t *reg, uint8_t bit, bool value) {
+    *bitbandAlias(reg, bit) = value;
+}
+
+/**
+ * @brief Reads one bit of a register or SRAM word.
+ *
+ * @param reg Pointer to the register.
+ * @param bit The bit number to read.
+ *
+ * @return The value of the bit.
+ */
+BITBAND_INLINE bool bitbandRead(volatile uint32_t *reg, uint8_t bit) {
+    return *bitbandAlias(reg, bit) != 0;
+}
+
+#endif // !BITBAND_H
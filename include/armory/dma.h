@@ -0,0 +1,133 @@
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DMA controller base addresses
+#define DMA1_BASE 0x40026000
+#define DMA2_BASE 0x40026400
+
+// DMA stream CR register bit definitions
+#define DMA_SxCR_EN         (1U << 0)   // Stream enable
+#define DMA_SxCR_DMEIE      (1U << 1)   // Direct mode error interrupt enable
+#define DMA_SxCR_TEIE       (1U << 2)   // Transfer error interrupt enable
+#define DMA_SxCR_HTIE       (1U << 3)   // Half transfer interrupt enable
+#define DMA_SxCR_TCIE       (1U << 4)   // Transfer complete interrupt enable
+#define DMA_SxCR_PFCTRL     (1U << 5)   // Peripheral flow controller
+#define DMA_SxCR_DIR_P2M    (0b00U << 6) // Peripheral to memory
+#define DMA_SxCR_DIR_M2P    (0b01U << 6) // Memory to peripheral
+#define DMA_SxCR_DIR_M2M    (0b10U << 6) // Memory to memory
+#define DMA_SxCR_CIRC       (1U << 8)   // Circular mode
+#define DMA_SxCR_PINC       (1U << 9)   // Peripheral increment mode
+#define DMA_SxCR_MINC       (1U << 10)  // Memory increment mode
+#define DMA_SxCR_PSIZE_Pos  11          // Peripheral data size
+#define DMA_SxCR_MSIZE_Pos  13          // Memory data size
+#define DMA_SxCR_PL_Pos     16          // Priority level
+#define DMA_SxCR_DBM        (1U << 18)  // Double buffer mode
+#define DMA_SxCR_CT         (1U << 19)  // Current target (M0AR/M1AR)
+#define DMA_SxCR_CHSEL_Pos  25          // Channel selection
+
+// DMA data sizes for PSIZE/MSIZE
+#define DMA_SIZE_BYTE       0b00U
+#define DMA_SIZE_HALFWORD   0b01U
+#define DMA_SIZE_WORD       0b10U
+
+// Per-stream interrupt flags, as returned by dmaGetFlags
+#define DMA_FLAG_FE         (1U << 0)   // FIFO error
+#define DMA_FLAG_DME        (1U << 2)   // Direct mode error
+#define DMA_FLAG_TE         (1U << 3)   // Transfer error
+#define DMA_FLAG_HT         (1U << 4)   // Half transfer
+#define DMA_FLAG_TC         (1U << 5)   // Transfer complete
+#define DMA_FLAG_ALL        (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE | DMA_FLAG_HT | DMA_FLAG_TC)
+
+// Typedef for easy access to DMA stream registers
+typedef struct {
+    volatile uint32_t CR;         // 0x00
+    volatile uint32_t NDTR;       // 0x04
+    volatile uint32_t PAR;        // 0x08
+    volatile uint32_t M0AR;       // 0x0C
+    volatile uint32_t M1AR;       // 0x10
+    volatile uint32_t FCR;        // 0x14
+} DMA_Stream_TypeDef;
+
+// Typedef for easy access to DMA controller registers
+typedef struct {
+    volatile uint32_t LISR;       // 0x00
+    volatile uint32_t HISR;       // 0x04
+    volatile uint32_t LIFCR;      // 0x08
+    volatile uint32_t HIFCR;      // 0x0C
+    DMA_Stream_TypeDef STREAM[8]; // 0x10 + 0x18 * stream
+} DMA_TypeDef;
+
+#define DMA1 ((DMA_TypeDef *)(DMA1_BASE))
+#define DMA2 ((DMA_TypeDef *)(DMA2_BASE))
+
+// Callback run from the stream interrupt with the flags that were raised
+typedef void (*DmaCallback)(uint32_t flags, void *context);
+
+/**
+ * @brief Initializes a DMA controller.
+ *
+ * Enables the clock of the given DMA controller in the RCC.
+ *
+ * @param dma Pointer to the DMA controller to initialize.
+ */
+void dmaInit(DMA_TypeDef *dma);
+
+/**
+ * @brief Gets the register block of a DMA stream.
+ *
+ * @param dma Pointer to the DMA controller the stream belongs to.
+ * @param stream The stream number (0 - 7).
+ *
+ * @return Pointer to the stream registers.
+ */
+DMA_Stream_TypeDef *dmaGetStream(DMA_TypeDef *dma, uint8_t stream);
+
+/**
+ * @brief Disables a DMA stream and waits until it has stopped.
+ *
+ * The stream registers may only be reprogrammed once EN reads back as 0.
+ *
+ * @param dma Pointer to the DMA controller the stream belongs to.
+ * @param stream The stream number (0 - 7).
+ */
+void dmaDisableStream(DMA_TypeDef *dma, uint8_t stream);
+
+/**
+ * @brief Reads the interrupt flags of a DMA stream.
+ *
+ * @param dma Pointer to the DMA controller the stream belongs to.
+ * @param stream The stream number (0 - 7).
+ *
+ * @return The stream flags, as a combination of DMA_FLAG_* values.
+ */
+uint32_t dmaGetFlags(DMA_TypeDef *dma, uint8_t stream);
+
+/**
+ * @brief Clears interrupt flags of a DMA stream.
+ *
+ * @param dma Pointer to the DMA controller the stream belongs to.
+ * @param stream The stream number (0 - 7).
+ * @param flags The flags to clear, as a combination of DMA_FLAG_* values.
+ */
+void dmaClearFlags(DMA_TypeDef *dma, uint8_t stream, uint32_t flags);
+
+/**
+ * @brief Attaches a callback to the interrupt of a DMA stream.
+ *
+ * Stores the callback and enables the stream interrupt in the NVIC. The
+ * stream flags are cleared before the callback is run.
+ *
+ * @param dma Pointer to the DMA controller the stream belongs to.
+ * @param stream The stream number (0 - 7).
+ * @param callback Function to call from the stream interrupt, or NULL.
+ * @param context User pointer passed to the callback.
+ *
+ * @note Which interrupts fire is still selected with the TCIE/HTIE/TEIE bits
+ *       in the stream CR register.
+ */
+void dmaSetCallback(DMA_TypeDef *dma, uint8_t stream, DmaCallback callback, void *context);
+
+#endif // !DMA_H
@@ -0,0 +1,87 @@
+#ifndef EXTI_H
+#define EXTI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gpio.h"
+
+// External interrupt controller and system configuration base addresses
+#define EXTI_BASE   0x40013C00
+#define SYSCFG_BASE 0x40013800
+
+// Define EXTI register offsets in typedef struct
+typedef struct {
+    volatile uint32_t IMR;      // 0x00
+    volatile uint32_t EMR;      // 0x04
+    volatile uint32_t RTSR;     // 0x08
+    volatile uint32_t FTSR;     // 0x0C
+    volatile uint32_t SWIER;    // 0x10
+    volatile uint32_t PR;       // 0x14
+} EXTI_TypeDef;
+
+// Define SYSCFG register offsets in typedef struct
+typedef struct {
+    volatile uint32_t MEMRMP;     // 0x00
+    volatile uint32_t PMC;        // 0x04
+    volatile uint32_t EXTICR[4];  // 0x08 - 0x14
+    uint32_t RESERVED[2];         // 0x18 & 0x1C
+    volatile uint32_t CMPCR;      // 0x20
+} SYSCFG_TypeDef;
+
+#define EXTI   ((EXTI_TypeDef *) EXTI_BASE)
+#define SYSCFG ((SYSCFG_TypeDef *) SYSCFG_BASE)
+
+// One EXTI line per pin number, shared by every port
+#define EXTI_LINE_COUNT 16
+
+// TIM5 counts debounce time in microseconds
+#define EXTI_DEBOUNCE_TIMER_HZ 1000000U
+
+// Priority the EXTI and debounce timer interrupts run at
+#ifndef EXTI_IRQ_PRIORITY
+#define EXTI_IRQ_PRIORITY 8
+#endif
+
+// Typedef for the edges a callback is attached to
+typedef enum {
+    EXTI_RISING  = 1,
+    EXTI_FALLING = 2,
+    EXTI_BOTH    = 3
+} ExtiEdge;
+
+// Called from interrupt context with the settled level of the pin
+typedef void (*ExtiCallback)(Pin pin, PinState level, void *context);
+
+/**
+ * @brief Attaches a callback to edges on a pin.
+ *
+ * Routes the pin's EXTI line to its port through SYSCFG and enables the
+ * interrupt. The pin should already be configured as an input.
+ *
+ * With a debounce time, the first edge masks the line and arms a TIM5
+ * compare for debounceUs later. Bounces in between are ignored, and the
+ * callback only runs if the pin then reads the level the edge leads to,
+ * so a press is reported a fixed debounceUs after it starts. No CPU time
+ * is spent on idle or bouncing inputs.
+ *
+ * @param pin The pin to watch. Only one port can use each pin number.
+ * @param edge The edges to report.
+ * @param debounceUs How long the pin has to settle before its level is
+ *                   reported, or 0 to call back straight from the edge.
+ * @param callback Function to call from interrupt context.
+ * @param context User pointer passed to the callback.
+ *
+ * @return False if the line is already attached to another port, or the
+ *         pin or callback is invalid.
+ */
+bool extiAttach(Pin pin, ExtiEdge edge, uint32_t debounceUs, ExtiCallback callback, void *context);
+
+/**
+ * @brief Detaches the callback from a pin and disables its EXTI line.
+ *
+ * @param pin The pin to stop watching.
+ */
+void extiDetach(Pin pin);
+
+#endif // !EXTI_H
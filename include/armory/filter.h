@@ -0,0 +1,108 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Filters for blocks of ADC samples, e.g. from adcStreamStart.
+//
+// The block functions read and write two 16 bit samples per word with the
+// Cortex-M4 DSP instructions (SADD16, SSUB16, SMLAD), so blocks must be
+// word aligned and an even number of samples long. Samples are unsigned
+// and up to 12 bits, as they come from the ADC. Division is done with
+// shifts and reciprocals, nothing needs libgcc.
+
+// Longest moving average window, which keeps the reciprocal within 1 LSB
+#define FILTER_MAX_WINDOW 256
+
+// Fraction bits of the moving average reciprocal
+#define FILTER_RECIPROCAL_BITS 19
+
+// Fraction bits of the IIR filter state
+#define FILTER_IIR_FRACTION_BITS 15
+
+// State of a moving average over the last window samples
+typedef struct {
+    uint16_t *history;      // The last window samples, a ring
+    uint16_t window;        // Samples averaged, even
+    uint16_t index;         // Next history slot to replace
+    uint32_t sum;           // Sum of the samples in history
+    uint32_t reciprocal;    // 2^19 / window, rounded
+} MovingAverage;
+
+// State of a first-order low pass IIR filter, y += alpha * (x - y)
+typedef struct {
+    int16_t alpha;          // Q15 weight of the new sample (1 - 32767)
+    int32_t acc;            // Output with 15 fraction bits
+} IirFilter;
+
+/**
+ * @brief Averages groups of samples into one, oversampling as it goes.
+ *
+ * Each output is the sum of 2^factorLog2 inputs shifted right by
+ * factorLog2 - extraBits. Every 4x oversampling of a noisy signal gains one
+ * bit, e.g. 16 samples and 2 extra bits give 14 bit results. That allows at
+ * most factorLog2 / 2 extra bits, so 12 bit inputs give at most 16 bits.
+ *
+ * @param in Input samples, word aligned.
+ * @param length Number of input samples, a multiple of 2^factorLog2.
+ * @param factorLog2 Log2 of the samples per output (1 - 8).
+ * @param extraBits Bits of resolution to keep (0 - factorLog2 / 2).
+ * @param out Buffer for length >> factorLog2 outputs. May be the same as in.
+ *
+ * @return The number of outputs written, 0 if factorLog2 or extraBits is
+ *         out of range.
+ */
+uint16_t filterDecimate(const uint16_t *in, uint16_t length, uint8_t factorLog2, uint8_t extraBits, uint16_t *out);
+
+/**
+ * @brief Sets up a moving average, starting from a history of zeros.
+ *
+ * @param f Pointer to the filter state.
+ * @param history Buffer of window samples, word aligned.
+ * @param window Samples averaged, even (2 - FILTER_MAX_WINDOW).
+ *
+ * @return False if the window is invalid.
+ */
+bool filterMovingAverageInit(MovingAverage *f, uint16_t *history, uint16_t window);
+
+/**
+ * @brief Runs a block through a moving average.
+ *
+ * Costs the same per sample whatever the window, the oldest sample is
+ * subtracted from a running sum as each new one is added. Outputs are
+ * rounded, exactly for power of two windows and within 1 LSB otherwise.
+ *
+ * @param f Pointer to the filter state.
+ * @param in Input samples, word aligned.
+ * @param out Buffer for length outputs, word aligned. May be the same as in.
+ * @param length Number of samples, even.
+ */
+void filterMovingAverage(MovingAverage *f, const uint16_t *in, uint16_t *out, uint16_t length);
+
+/**
+ * @brief Sets up a first-order IIR low pass filter.
+ *
+ * @param f Pointer to the filter state.
+ * @param alpha Q15 weight of each new sample (1 - 32767). Smaller values
+ *              filter more, 32768 / alpha is roughly the time constant in
+ *              samples.
+ * @param initial Output to start from, e.g. the first sample.
+ */
+void filterIirInit(IirFilter *f, int16_t alpha, uint16_t initial);
+
+/**
+ * @brief Runs a block through a first-order IIR low pass filter.
+ *
+ * Each output is alpha * x + (1 - alpha) * y, one SMLAD per sample. The
+ * state keeps 15 fraction bits, so even the smallest alphas settle exactly
+ * on a constant input.
+ *
+ * @param f Pointer to the filter state.
+ * @param in Input samples, word aligned.
+ * @param out Buffer for length outputs, word aligned. May be the same as in.
+ * @param length Number of samples, even.
+ */
+void filterIir(IirFilter *f, const uint16_t *in, uint16_t *out, uint16_t length);
+
+#endif // !FILTER_H
@@ -0,0 +1,25 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+// A fixed width bitmap font, stored in flash.
+//
+// Glyphs are column-major in the same layout as SH1106 framebuffer pages:
+// each column is (height + 7) / 8 bytes, top byte first, with bit 0 as the
+// top row of the byte. A glyph is width columns, and glyphs are stored in
+// character order starting at first.
+typedef struct {
+    uint8_t width;          // Glyph width in columns
+    uint8_t height;         // Glyph height in rows
+    uint8_t first;          // First character in the table
+    uint8_t count;          // Number of characters in the table
+    uint8_t spacing;        // Blank columns after each glyph
+    const uint8_t *glyphs;  // Glyph data, see above
+} Font;
+
+// Printable ASCII (' ' to '~') in two sizes
+extern const Font font5x7;
+extern const Font font10x14;
+
+#endif // !FONT_H
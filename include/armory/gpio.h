@@ -4,6 +4,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include <armory/tim.h>
 
@@ -94,6 +95,19 @@ typedef struct {
 #define B15 ((Pin) {GPIOB, 15})
 
 // Pins in port C
+#define C0  ((Pin) {GPIOC, 0})
+#define C1  ((Pin) {GPIOC, 1})
+#define C2  ((Pin) {GPIOC, 2})
+#define C3  ((Pin) {GPIOC, 3})
+#define C4  ((Pin) {GPIOC, 4})
+#define C5  ((Pin) {GPIOC, 5})
+#define C6  ((Pin) {GPIOC, 6})
+#define C7  ((Pin) {GPIOC, 7})
+#define C8  ((Pin) {GPIOC, 8})
+#define C9  ((Pin) {GPIOC, 9})
+#define C10 ((Pin) {GPIOC, 10})
+#define C11 ((Pin) {GPIOC, 11})
+#define C12 ((Pin) {GPIOC, 12})
 #define C13 ((Pin) {GPIOC, 13})
 #define C14 ((Pin) {GPIOC, 14})
 #define C15 ((Pin) {GPIOC, 15})
@@ -156,6 +170,35 @@ typedef enum {
     OPEN_DRAIN = 0x01
 } OutputType;
 
+// Typedef for pin output speeds (edge rates), faster edges cost more EMI
+typedef enum {
+    LOW_SPEED    = 0x00,
+    MEDIUM_SPEED = 0x01,
+    FAST_SPEED   = 0x02,
+    HIGH_SPEED   = 0x03
+} OutputSpeed;
+
+// Full configuration of one pin, for gpioConfigure
+typedef struct {
+    Pin pin;
+    PinMode mode;
+    OutputType otype;
+    OutputSpeed speed;
+    PinPullMode pull;
+    AlternateFunction af;   // Only used in ALTERNATE_FUNC mode
+} PinConfig;
+
+// Pins of one port driven together, e.g. a parallel data bus. Bit i of a
+// group value belongs to pins[i].
+typedef struct {
+    GPIO_TypeDef *port;
+    uint16_t mask;          // Port bits of every pin in the group
+    uint8_t count;          // Number of pins
+    uint8_t shift;          // Lowest pin, when the pins are in order
+    bool contiguous;        // Pins are shift, shift + 1, ... in order
+    uint8_t pins[16];       // Pin number of each group bit
+} PinGroup;
+
 /**
  * @brief Initialized a specific GPIO port.
  *
@@ -197,6 +240,27 @@ void gpioSetAlternateFunction(Pin pin, AlternateFunction af);
  */
 void gpioSetOutputType(Pin pin, OutputType otype);
 
+/**
+ * @brief Sets the output speed for a specific GPIO pin.
+ *
+ * @param pin The pin to set the output speed for.
+ * @param speed The output speed to set for the pin.
+ */
+void gpioSetOutputSpeed(Pin pin, OutputSpeed speed);
+
+/**
+ * @brief Configures many pins at once.
+ *
+ * Entries are grouped by port. For each port the clock is enabled, then the
+ * AFR, OTYPER, OSPEEDR, PUPDR and MODER values are built for every pin of
+ * the port and each register is written once. MODER goes last, so a pin
+ * only starts driving once its type, speed and function are in place.
+ *
+ * @param cfg Array of pin configurations.
+ * @param n Number of entries in cfg.
+ */
+void gpioConfigure(const PinConfig cfg[], uint8_t n);
+
 /**
  * @brief Writes a digital value to a specific GPIO pin.
  *
@@ -225,4 +289,117 @@ void gpioSetPull(Pin pin, PinPullMode pull);
  */
 PinState gpioDigitalRead(Pin pin);
 
+/**
+ * @brief Sets and clears any pins of a port with one BSRR write.
+ *
+ * Every pin changes on the same clock edge, and pins outside both masks
+ * are left alone, even if an interrupt changes them at the same time.
+ *
+ * @param port Pointer to the GPIO port to write.
+ * @param setMask Pins to drive high, bit n is pin n.
+ * @param clearMask Pins to drive low. Pins in both masks are driven high.
+ */
+void gpioWritePort(GPIO_TypeDef *port, uint16_t setMask, uint16_t clearMask);
+
+/**
+ * @brief Reads several pins of a port at the same instant.
+ *
+ * @param port Pointer to the GPIO port to read.
+ * @param mask Pins to read, bit n is pin n.
+ *
+ * @return The IDR bits selected by mask.
+ */
+uint16_t gpioReadPort(GPIO_TypeDef *port, uint16_t mask);
+
+/**
+ * @brief Builds a group from pins of one port.
+ *
+ * @param group Pointer to the group to fill in.
+ * @param pins Array of pins, pins[0] becomes bit 0 of the group value.
+ * @param count Number of pins, at most 16.
+ *
+ * @return True on success, false if the pins are not all on one port or
+ *         a pin is listed twice.
+ */
+bool gpioGroupInit(PinGroup *group, const Pin pins[], uint8_t count);
+
+/**
+ * @brief Writes a value to every pin of a group in one BSRR write.
+ *
+ * @param group Pointer to the group to write.
+ * @param value The value, bit i drives the group's pin i.
+ *
+ * @note The pins' mode should be set to OUTPUT before calling this.
+ */
+void gpioGroupWrite(const PinGroup *group, uint16_t value);
+
+/**
+ * @brief Reads every pin of a group in one IDR read.
+ *
+ * @param group Pointer to the group to read.
+ *
+ * @return The group value, bit i is the level of the group's pin i.
+ */
+uint16_t gpioGroupRead(const PinGroup *group);
+
+// Fast-path pin access, defined in this header so calls are inlined even at
+// -O0. With optimization enabled and a constant pin such as A8, each write
+// compiles to a single BSRR store and each read to a single IDR load.
+#define GPIO_INLINE static inline __attribute__((always_inline))
+
+/**
+ * @brief Drives a pin high with a single BSRR store.
+ *
+ * @param pin The pin to set.
+ */
+GPIO_INLINE void gpioSetFast(Pin pin) {
+    pin.port->BSRR = PIN_MASK(pin.pin);
+}
+
+/**
+ * @brief Drives a pin low with a single BSRR store.
+ *
+ * @param pin The pin to clear.
+ */
+GPIO_INLINE void gpioClearFast(Pin pin) {
+    pin.port->BSRR = PIN_RESET_MASK(pin.pin);
+}
+
+/**
+ * @brief Inlined version of gpioWrite.
+ *
+ * @param pin The pin to write to.
+ * @param value The value to write to the pin (HIGH/LOW).
+ *
+ * @note Only a constant value avoids the branch, use gpioSetFast or
+ *       gpioClearFast when the level is known up front.
+ */
+GPIO_INLINE void gpioWriteFast(Pin pin, PinState value) {
+    pin.port->BSRR = value ? PIN_MASK(pin.pin) : PIN_RESET_MASK(pin.pin);
+}
+
+/**
+ * @brief Inverts an output pin.
+ *
+ * Reads ODR and writes BSRR, so other pins of the port can be changed from
+ * interrupts in between without being overwritten.
+ *
+ * @param pin The pin to toggle.
+ */
+GPIO_INLINE void gpioToggleFast(Pin pin) {
+    uint32_t mask = PIN_MASK(pin.pin);
+    pin.port->BSRR = (pin.port->ODR & mask) ? (mask << 16) : mask;
+}
+
+/**
+ * @brief Inlined version of gpioDigitalRead, a single IDR load.
+ *
+ * @param pin The pin to read from.
+ *
+ * @return The pin level (HIGH/LOW).
+ */
+GPIO_INLINE PinState gpioReadFast(Pin pin) {
+    return (PinState)((pin.port->IDR >> pin.pin) & 1U);
+}
+
 #endif // !GPIO_H
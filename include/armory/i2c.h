@@ -7,10 +7,34 @@
 
 #include "gpio.h"
 
-#define I2C_TIMEOUT_TIME 10000
+// Time a polled wait may take before giving up. Transactions get this much
+// slack on top of their nominal bus time, for targets that stretch the clock.
+#define I2C_TIMEOUT_US 1000
+
+// Bus recovery clocks SCL at 100 kHz, for at most 9 pulses plus a STOP
+#define I2C_RECOVERY_CLOCKS          9
+#define I2C_RECOVERY_HALF_PERIOD_US  5
+#define I2C_RECOVERY_MAX_US          ((2 * I2C_RECOVERY_CLOCKS + 5) * I2C_RECOVERY_HALF_PERIOD_US)
+
+// Transaction statistics are compiled out unless built with
+// -DI2C_STATS_ENABLED=1 (make EXTRA_CFLAGS=-DI2C_STATS_ENABLED=1)
+#ifndef I2C_STATS_ENABLED
+#define I2C_STATS_ENABLED 0
+#endif
+
+// Latency histogram layout. Bucket 0 counts transactions under
+// 2^I2C_STATS_BUCKET_SHIFT DWT cycles, each following bucket covers twice
+// the range of the one before, and the last also holds everything slower.
+#define I2C_STATS_BUCKETS      16
+#define I2C_STATS_BUCKET_SHIFT 10
+
+// Messages of at least this many bytes use DMA once it is enabled. Reads
+// need two or more bytes for the DMA LAST bit to NACK the final one.
+#define I2C_DMA_MIN_LEN 2
 
 #define I2C_CR1_PE    ( 1 <<  0 )
 #define I2C_SR1_RXNE  ( 1 <<  6 )
+#define I2C_CR1_NOSTRETCH ( 1 << 7 )
 #define I2C_CR1_START ( 1 <<  8 )
 #define I2C_CR1_STOP  ( 1 <<  9 )
 #define I2C_CR1_ACK   ( 1 << 10 )
@@ -19,9 +43,37 @@
 #define I2C_SR1_SB    ( 1 <<  0 )
 #define I2C_SR1_ADDR  ( 1 <<  1 )
 #define I2C_SR1_BTF   ( 1 <<  2 )
+#define I2C_SR1_STOPF ( 1 <<  4 )
+#define I2C_SR1_TXE   ( 1 <<  7 )
+#define I2C_SR1_BERR  ( 1 <<  8 )
+#define I2C_SR1_ARLO  ( 1 <<  9 )
 #define I2C_SR1_AF    ( 1 << 10 )
+#define I2C_SR1_OVR   ( 1 << 11 )
+
+#define I2C_CR2_FREQ    ( 0x3F << 0 )
+#define I2C_CR2_ITERREN ( 1 <<  8 )
+#define I2C_CR2_ITEVTEN ( 1 <<  9 )
+#define I2C_CR2_ITBUFEN ( 1 << 10 )
+#define I2C_CR2_DMAEN   ( 1 << 11 )
+#define I2C_CR2_LAST    ( 1 << 12 )
+
+#define I2C_CCR_CCR   ( 0xFFF << 0 )
+#define I2C_CCR_DUTY  ( 1 << 14 )
+#define I2C_CCR_FS    ( 1 << 15 )
+
+// Standard bus speeds, any other SCL frequency up to 400 kHz may be used
+#define I2C_SPEED_STANDARD  100000U
+#define I2C_SPEED_FAST      400000U
 
 #define I2C_SR2_BUSY  ( 1 <<  1 )
+#define I2C_SR2_TRA   ( 1 <<  2 )
+#define I2C_SR2_DUALF ( 1 <<  7 )
+
+// Own address registers. Bit 14 of OAR1 must always be written as 1.
+#define I2C_OAR1_ADD_Pos   1
+#define I2C_OAR1_RESERVED  ( 1 << 14 )
+#define I2C_OAR2_ENDUAL    ( 1 <<  0 )
+#define I2C_OAR2_ADD2_Pos  1
 
 typedef struct {
     volatile uint32_t CR1;       // 0x00: Control register 1
@@ -40,6 +92,12 @@ typedef struct {
 #define I2C2 ((I2C_TypeDef *)0x40005800)
 #define I2C3 ((I2C_TypeDef *)0x40005C00)
 
+// Fast mode SCL low/high ratio. Ignored in standard mode, which is always 1:1.
+typedef enum {
+    I2C_DUTY_2,         // Tlow/Thigh = 2, reaches 400 kHz exactly from 42 MHz
+    I2C_DUTY_16_9       // Tlow/Thigh = 16/9, needs PCLK1 to be a multiple of 10 MHz
+} I2CDutyCycle;
+
 typedef struct {
     I2C_TypeDef *instance;
 
@@ -50,31 +108,133 @@ typedef struct {
     AlternateFunction sdaAf;
 } I2CMap;
 
-// I2C pin mappings:
+// A pin that can carry one line of an I2C controller
+typedef struct {
+    I2C_TypeDef *instance;
+    Pin pin;
+    AlternateFunction af;
+} I2CPinOption;
+
+// Every SCL and SDA pin option on the STM32F411
+// I2C1:
+//  SCL->PB6, PB8 (AF4)
+//  SDA->PB7, PB9 (AF4)
+// I2C2:
+//  SCL->PB10 (AF4)
+//  SDA->PB11 (AF4), PB3, PB9 (AF9)
+// I2C3:
+//  SCL->PA8 (AF4)
+//  SDA->PC9 (AF4), PB4, PB8 (AF9)
+extern const I2CPinOption i2cSclPins[];
+extern const I2CPinOption i2cSdaPins[];
+
+// Default I2C pin mappings, until changed with i2cSetPins:
 // I2C1:
 //  SCL->PB6
 //  SDA->PB7
 // I2C2:
 //  SCL->B10
 //  SDA->B11
-//
-//  I2C3 remains unmapped for now
-//
-//  NOTE: These can be mapped to multiple different pins. There were
-//  arbitrarily chosen and are not set in stone
-static const I2CMap i2cPinMap[] = {
-    { I2C1, B6,  AF4, B7,  AF4 },
-    { I2C2, B10, AF4, B11, AF4 }
-    //{ I2C3,  }
-};
+// I2C3:
+//  SCL->A8
+//  SDA->B4
 
 typedef enum {
     I2C_OK,
     I2C_TIMEOUT,
     I2C_NACK,
-    I2C_ERROR
+    I2C_ERROR,
+    I2C_BUSY
 } I2CResult;
 
+// I2CMessage flags
+#define I2C_MSG_READ  ( 1 << 0 )    // Read from the device instead of writing
+
+// One segment of a transaction, modeled after the Linux i2c_msg. Consecutive
+// messages are joined with a repeated START, only the last one ends in STOP.
+typedef struct {
+    uint8_t addr;           // 7-bit device address
+    uint8_t flags;          // I2C_MSG_* flags
+    uint16_t len;           // Number of bytes to transfer
+    uint8_t *buf;           // Buffer to send from or receive into
+} I2CMessage;
+
+typedef struct I2CTransaction I2CTransaction;
+
+// Completion callback, called once a transaction ends. Runs in interrupt
+// context, or from the caller of i2cWait/i2cPollTimeout on a timeout.
+typedef void (*I2CCallback)(I2CTransaction *txn);
+
+// A queued I2C transaction. Must stay valid until it completes.
+struct I2CTransaction {
+    I2CMessage *msgs;       // Messages to run back to back
+    uint8_t count;          // Number of messages
+    I2CCallback callback;   // Called on completion, may be NULL
+    void *context;          // User data for the callback
+
+    // Managed by the driver
+    I2C_TypeDef *instance;
+    volatile I2CResult result;
+    uint8_t msgIndex;
+    uint16_t index;
+    I2CTransaction *next;
+};
+
+// Target mode events passed to the I2CTargetCallback
+typedef enum {
+    I2C_TARGET_ADDRESS,     // A host addressed us, data is already moving
+    I2C_TARGET_STOP         // The transfer ended (STOP, or NACK after a read)
+} I2CTargetEvent;
+
+typedef struct I2CTarget I2CTarget;
+
+// Target mode callback. Runs in interrupt context.
+typedef void (*I2CTargetCallback)(I2CTarget *target, I2CTargetEvent event);
+
+// An I2C target (slave) exposing a register map. A host write starts with
+// the register index, every following byte is stored from that index on.
+// A host read returns the register map from the last index written.
+struct I2CTarget {
+    uint8_t addr;               // 7-bit own address (OAR1)
+    uint8_t addr2;              // Optional second 7-bit address (OAR2), 0 if unused
+    uint8_t *regs;              // Register map the host reads and writes
+    uint8_t *staging;           // size + 1 bytes, host writes land here until STOP
+    uint16_t size;              // Size of the register map, at most 256
+    I2CTargetCallback callback; // Called on address match and STOP, may be NULL
+    void *context;              // User data for the callback
+
+    // Managed by the driver, valid inside the callback
+    I2C_TypeDef *instance;
+    uint8_t matched;            // Which of addr/addr2 the host used
+    bool reading;               // The host is reading from the map
+    uint8_t reg;                // Register index of the transfer
+    uint16_t count;             // Bytes written or read, set on I2C_TARGET_STOP
+    uint32_t overruns;          // Bytes the DMA was not ready for, see i2cTargetInit
+};
+
+#if I2C_STATS_ENABLED
+// Transaction types tracked by the statistics
+typedef enum {
+    I2C_STAT_WRITE,         // Only write messages
+    I2C_STAT_READ,          // Only read messages
+    I2C_STAT_WRITE_READ,    // Mixed, e.g. a register address write then a read
+    I2C_STAT_TYPE_COUNT
+} I2CStatType;
+
+// Counters collected for each I2C peripheral
+typedef struct {
+    uint32_t transactions[I2C_STAT_TYPE_COUNT];
+    uint32_t bytes;         // Data bytes moved, not counting addresses
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t errors;        // Bus errors, arbitration loss, overruns
+
+    // Latency from START to completion, in DWT cycles
+    uint32_t histogram[I2C_STAT_TYPE_COUNT][I2C_STATS_BUCKETS];
+    uint32_t maxCycles[I2C_STAT_TYPE_COUNT];
+} I2CStats;
+#endif
+
 /**
  * @brief Gets the I2CMap for the given I2C instance.
  * 
@@ -83,33 +243,293 @@ typedef enum {
  */
 const I2CMap *getI2CMap(I2C_TypeDef *i2c);
 
+/**
+ * @brief Selects the SCL and SDA pins of an I2C instance.
+ *
+ * Checks both pins against the i2cSclPins/i2cSdaPins tables and stores the
+ * mapping, along with the alternate function each pin needs.
+ *
+ * @param i2c Pointer to the I2C instance to map.
+ * @param scl The pin to use for SCL.
+ * @param sda The pin to use for SDA.
+ *
+ * @return I2C_OK on success, or I2C_ERROR if either pin cannot carry the
+ *         line for this instance.
+ *
+ * @note Must be called before i2cInit (or i2cInitSpeed) to take effect.
+ */
+I2CResult i2cSetPins(I2C_TypeDef *i2c, Pin scl, Pin sda);
+
 /**
  * @brief Initializes the I2C peripheral.
  * 
  * Enables the I2C clock, configures the GPIO pins for SCL and SDA,
- * and sets the I2C clock speed.
+ * and sets the I2C clock speed to 400 kHz fast mode.
  *
  * @param i2c Pointer to the I2C instance to initialize.
  */
 void i2cInit(I2C_TypeDef *i2c);
 
+/**
+ * @brief Initializes the I2C peripheral at a given bus speed.
+ *
+ * Same as i2cInit, but computes the CR2, CCR and TRISE timing registers for
+ * the requested SCL frequency from the current PCLK1. Frequencies up to
+ * 100 kHz use standard mode, anything above uses fast mode with the given
+ * duty cycle. The divider is rounded so the bus never runs faster than
+ * requested.
+ *
+ * @param i2c Pointer to the I2C instance to initialize.
+ * @param sclFreq The target SCL frequency in Hz (e.g. I2C_SPEED_FAST).
+ * @param duty The fast mode duty cycle.
+ *
+ * @return I2C_OK on success, or I2C_ERROR if the speed cannot be reached
+ *         from the current PCLK1.
+ *
+ * @note Must be called again if the clock tree changes.
+ */
+I2CResult i2cInitSpeed(I2C_TypeDef *i2c, uint32_t sclFreq, I2CDutyCycle duty);
+
+/**
+ * @brief Gets the SCL frequency the I2C peripheral is configured for.
+ *
+ * @param i2c Pointer to the I2C instance to check.
+ *
+ * @return The nominal SCL frequency in Hz. The real frequency is slightly
+ *         lower, as SCL rise time adds to every clock period.
+ */
+uint32_t i2cGetSpeed(I2C_TypeDef *i2c);
+
+/**
+ * @brief Queues a transaction on the I2C bus without blocking.
+ *
+ * The transaction is appended to the bus queue and started as soon as the
+ * bus is free. Every bus phase (START, address, data, repeated START, STOP)
+ * is then driven by the I2C event and error interrupts, so the CPU is free
+ * while data moves. When the transaction ends, its result field is set and its
+ * callback (if any) is called from interrupt context.
+ *
+ * @param i2c Pointer to the I2C instance to run the transaction on.
+ * @param txn Pointer to the transaction to queue.
+ *
+ * @return I2C_OK if the transaction was queued, I2C_ERROR if it is invalid.
+ *
+ * @note The transaction, its messages and their buffers must remain valid
+ *       until the transaction has completed.
+ */
+I2CResult i2cSubmit(I2C_TypeDef *i2c, I2CTransaction *txn);
+
+/**
+ * @brief Runs an array of messages as one I2C transaction.
+ *
+ * Issues a START, then runs each message in order, joining them with
+ * repeated STARTs so the bus is never released in between. A single STOP
+ * ends the transaction. For example, a register read is a one byte write of
+ * the register address followed by a read message.
+ *
+ * @param i2c Pointer to the I2C instance to run the transaction on.
+ * @param msgs Pointer to the array of messages.
+ * @param n The number of messages in the array.
+ *
+ * @return I2CResult indicating the result of the transaction.
+ *
+ * @note Blocks until the transaction is done, see i2cSubmit for the
+ *       non-blocking version.
+ */
+I2CResult i2cTransfer(I2C_TypeDef *i2c, I2CMessage *msgs, uint8_t n);
+
+/**
+ * @brief Enables or disables DMA transfers on an I2C bus.
+ *
+ * When enabled, transactions of I2C_DMA_MIN_LEN bytes or more are moved by
+ * DMA1 instead of the TXE/RXNE interrupts, so a whole buffer is transferred
+ * without any per-byte CPU work. Reads use the LAST bit so the final byte is
+ * NACKed by hardware.
+ *
+ * DMA1 streams used (stream/channel):
+ *  I2C1: RX 0/1, TX 6/1
+ *  I2C2: RX 2/7, TX 7/7
+ *  I2C3: RX 1/1, TX 4/3
+ *
+ * @param i2c Pointer to the I2C instance to configure.
+ * @param enable True to use DMA for bulk transfers, false for interrupts only.
+ *
+ * @note Takes effect from the next transaction started on the bus.
+ */
+void i2cEnableDma(I2C_TypeDef *i2c, bool enable);
+
+/**
+ * @brief Puts an I2C instance in target (slave) mode.
+ *
+ * The controller answers to target->addr, and to target->addr2 as well when
+ * it is non-zero. Clock stretching is disabled (NOSTRETCH), so the bus never
+ * waits on the CPU. Instead, both DMA1 streams of the bus are kept armed
+ * between transfers: the RX stream receives a whole write, index and data,
+ * into target->staging, and the TX stream feeds the map from the index to
+ * the host. No interrupt sits between the bytes of a transfer:
+ *  - The first byte, to take the index of a write. Only a read after a
+ *    repeated START depends on it, and has until the host has sent the
+ *    repeated START and address (~25 us at 400 kHz).
+ *  - ADDR, to report I2C_TARGET_ADDRESS.
+ *  - STOP (or the NACK ending a read), to copy a write into the register
+ *    map, report I2C_TARGET_STOP and re-arm.
+ *
+ * @param i2c Pointer to the I2C instance to use.
+ * @param target Pointer to the target description, must stay valid.
+ *
+ * @return I2C_OK on success, I2C_ERROR if the target is invalid.
+ *
+ * @note Uses the same DMA1 streams as i2cEnableDma. Writes past the end of
+ *       the register map are dropped and reads past it return undefined
+ *       data. Each byte of those, and each read that started before the
+ *       index in front of it was handled, counts in target->overruns. When
+ *       a write is followed by a read with a repeated START, the write is
+ *       stored once the read is addressed and only one I2C_TARGET_STOP is
+ *       reported, for the read. Call i2cInit to go
+ *       back to master mode, i2cSubmit returns I2C_ERROR until then.
+ */
+I2CResult i2cTargetInit(I2C_TypeDef *i2c, I2CTarget *target);
+
+/**
+ * @brief Waits for a submitted transaction to complete.
+ *
+ * While waiting, the running transaction is checked against its deadline
+ * (see i2cGetTimeoutUs). Once that passes, it is aborted with I2C_TIMEOUT
+ * and the bus is recovered with i2cRecoverBus.
+ *
+ * @param txn Pointer to a transaction previously passed to i2cSubmit.
+ *
+ * @return The I2CResult of the transaction.
+ *
+ * @note Must not be called from an I2C callback or any interrupt with a
+ *       priority at or above the I2C interrupts, as it would never return.
+ */
+I2CResult i2cWait(const I2CTransaction *txn);
+
+/**
+ * @brief Aborts the running transaction if it has passed its deadline.
+ *
+ * i2cWait does this on its own. Code that only uses callbacks should call
+ * this regularly (e.g. once per main loop), so a hung bus is noticed.
+ *
+ * @param i2c Pointer to the I2C instance to check.
+ */
+void i2cPollTimeout(I2C_TypeDef *i2c);
+
+/**
+ * @brief Waits for several transactions, which may be on different buses.
+ *
+ * Each bus runs its own queue from its own interrupts and DMA streams, so
+ * transactions submitted to I2C1, I2C2 and I2C3 progress in parallel. This
+ * waits until all of them have finished, checking the deadline of every
+ * bus while doing so.
+ *
+ * @param txns Array of transactions previously passed to i2cSubmit.
+ * @param count Number of entries in txns.
+ *
+ * @return I2C_OK if every transaction succeeded, otherwise the result of
+ *         the first one in the array that failed.
+ *
+ * @note The same restrictions as for i2cWait apply.
+ */
+I2CResult i2cWaitAll(I2CTransaction *const txns[], uint8_t count);
+
+/**
+ * @brief Calls i2cPollTimeout on every I2C bus.
+ */
+void i2cPollAll(void);
+
+/**
+ * @brief Gets the deadline a transaction is given once it starts running.
+ *
+ * The deadline is the nominal time of every address and data byte at the
+ * configured bus speed, plus I2C_TIMEOUT_US of slack. A failed transaction
+ * therefore returns at most this long after it started, plus
+ * I2C_RECOVERY_MAX_US for the bus recovery.
+ *
+ * @param i2c Pointer to the I2C instance the transaction runs on.
+ * @param txn Pointer to the transaction.
+ *
+ * @return The deadline in microseconds.
+ */
+uint32_t i2cGetTimeoutUs(I2C_TypeDef *i2c, const I2CTransaction *txn);
+
+/**
+ * @brief Frees a stuck I2C bus and resets the peripheral.
+ *
+ * Takes SCL and SDA over as GPIO and clocks SCL up to I2C_RECOVERY_CLOCKS
+ * times until a target holding SDA low lets go, then issues a STOP. The
+ * peripheral is then reset and its bus timing restored. Takes at most
+ * I2C_RECOVERY_MAX_US.
+ *
+ * @param i2c Pointer to the I2C instance to recover.
+ *
+ * @return I2C_OK if both lines are released, I2C_ERROR otherwise.
+ *
+ * @note Must not be called while a transaction is running on the bus.
+ */
+I2CResult i2cRecoverBus(I2C_TypeDef *i2c);
+
+#if I2C_STATS_ENABLED
+/**
+ * @brief Gets a snapshot of the statistics of an I2C bus.
+ *
+ * Every transaction run through i2cSubmit (and so every blocking transfer
+ * helper) is counted when it completes.
+ *
+ * @param i2c Pointer to the I2C instance to get the statistics of.
+ * @param stats Pointer to the I2CStats to copy the statistics into.
+ *
+ * @return I2C_OK on success, I2C_ERROR if the instance is invalid.
+ *
+ * @note Only available when built with I2C_STATS_ENABLED.
+ */
+I2CResult i2cGetStats(I2C_TypeDef *i2c, I2CStats *stats);
+
+/**
+ * @brief Clears the statistics of an I2C bus.
+ *
+ * @param i2c Pointer to the I2C instance to clear the statistics of.
+ *
+ * @note Only available when built with I2C_STATS_ENABLED.
+ */
+void i2cResetStats(I2C_TypeDef *i2c);
+#endif
+
+/**
+ * @brief Checks whether an I2C bus has no queued or running transactions.
+ *
+ * @param i2c Pointer to the I2C instance to check.
+ *
+ * @return True if the bus queue is empty.
+ */
+bool i2cIsIdle(I2C_TypeDef *i2c);
+
 /**
  * @brief Starts the I2C communication.
  *
  * Issues a START condition on the I2C bus.
  *
  * @param i2c Pointer to the I2C instance to start communication on.
+ *
+ * @returns I2CResult indicating the result of the operation.
+ *
+ * @note This is a polled primitive for hand-built transfers. It must not be
+ *       used while queued transactions are running on the same bus.
  */
-void i2cStart(I2C_TypeDef *i2c);
+I2CResult i2cStart(I2C_TypeDef *i2c);
 
 /**
  * @brief Stops the I2C communication.
  *
- * Issues a STOP condition on the I2C bus.
+ * Issues a STOP condition on the I2C bus, then waits for the bus to be
+ * released.
  *
  * @param i2c Pointer to the I2C instance to stop communication on.
+ *
+ * @returns I2CResult indicating the result of the operation.
  */
-void i2cStop(I2C_TypeDef *i2c);
+I2CResult i2cStop(I2C_TypeDef *i2c);
 
 /**
  * @brief Sends the device address on the I2C bus.
@@ -141,6 +561,25 @@ I2CResult i2cSendAddr(I2C_TypeDef *i2c, uint8_t addr, bool read);
  */
 I2CResult i2cSendData(I2C_TypeDef *i2c, uint8_t data);
 
+/**
+ * @brief Receives a single data byte from the I2C bus.
+ *
+ * Sets whether the byte will be ACKed, then waits for it to arrive.
+ *
+ * @param i2c Pointer to the I2C instance to receive the data from.
+ * @param ack True to ACK the byte, false to NACK it (for the last byte).
+ * @param data Pointer to the variable to store the received byte in.
+ *
+ * @returns I2CResult indicating the result of the operation.
+ *
+ * @note This function is intended to only be called inside of other I2C functions,
+ *       but is exposed for convenience.
+ */
+I2CResult i2cReceiveData(I2C_TypeDef *i2c, bool ack, uint8_t *data);
+
+// The transfer functions below are blocking wrappers around i2cTransfer. They
+// wait for their transaction to finish and must not be called from interrupts.
+
 /**
  * @brief Writes a byte to a specific register of a device on the I2C bus.
  *
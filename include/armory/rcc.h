@@ -30,10 +30,34 @@
 #define RCC_PLLI2SCFGR_OFFSET  0x84
 #define RCC_DCKCFGR_OFFSET     0x8c
 
+// Oscillator frequencies. The HSE is the 25 MHz crystal on the board.
+#define RCC_HSI_FREQ           16000000U
+#define RCC_HSE_FREQ           25000000U
+
+// Bit definitions for enabling the GPIO ports
+#define RCC_AHB1ENR_GPIOAEN    (1U << 0)
+#define RCC_AHB1ENR_GPIOBEN    (1U << 1)
+#define RCC_AHB1ENR_GPIOCEN    (1U << 2)
+#define RCC_AHB1ENR_GPIODEN    (1U << 3)
+#define RCC_AHB1ENR_GPIOHEN    (1U << 7)
+
+// Bit definitions for enabling the DMA controllers
+#define RCC_AHB1ENR_DMA1EN     (1U << 21)
+#define RCC_AHB1ENR_DMA2EN     (1U << 22)
+
 // Bit definitions for enabling differnet i2cs
 #define RCC_APB1ENR_I2C1EN     (1U << 21)
 #define RCC_APB1ENR_I2C2EN     (1U << 22)
 #define RCC_APB1ENR_I2C3EN     (1U << 23)
+#define RCC_APB1ENR_TIM2EN     (1U << 0)
+#define RCC_APB1ENR_TIM3EN     (1U << 1)
+#define RCC_APB1ENR_TIM4EN     (1U << 2)
+#define RCC_APB1ENR_TIM5EN     (1U << 3)
+
+// APB2 peripheral clock enable bits
+#define RCC_APB2ENR_TIM1EN     (1U << 0)
+#define RCC_APB2ENR_ADC1EN     (1U << 8)
+#define RCC_APB2ENR_SYSCFGEN   (1U << 14)
 
 // RCC_CR
 #define RCC_CR_HSEON            (1 << 16)
@@ -52,6 +76,13 @@
 #define RCC_CFGR_SWS_PLL        (0b10 << 2)
 #define RCC_CFGR_SWS_MSK        (0b11 << 2)
 
+#define RCC_CFGR_SWS_HSI        (0b00 << 2)
+#define RCC_CFGR_SWS_HSE        (0b01 << 2)
+
+#define RCC_CFGR_HPRE_Pos       4
+#define RCC_CFGR_PPRE1_Pos      10
+#define RCC_CFGR_PPRE2_Pos      13
+
 #define RCC_CFGR_HPRE_DIV1      (0b0000 << 4)
 #define RCC_CFGR_PPRE1_DIV2     (0b100 << 10)
 #define RCC_CFGR_PPRE2_DIV1     (0b000 << 13)
@@ -104,4 +135,54 @@ typedef struct {
  */
 void rccInit(void);
 
+/**
+ * @brief Gets the current system clock frequency.
+ *
+ * Decodes the active clock source and PLL settings from the RCC registers.
+ *
+ * @return SYSCLK in Hz.
+ */
+uint32_t rccGetSysclkFreq(void);
+
+/**
+ * @brief Gets the current AHB bus clock frequency.
+ *
+ * @return HCLK in Hz.
+ */
+uint32_t rccGetHclkFreq(void);
+
+/**
+ * @brief Gets the current APB1 peripheral clock frequency.
+ *
+ * APB1 clocks I2C1-3, TIM2-5 and the other low speed peripherals.
+ *
+ * @return PCLK1 in Hz.
+ */
+uint32_t rccGetPclk1Freq(void);
+
+/**
+ * @brief Gets the current APB2 peripheral clock frequency.
+ *
+ * APB2 clocks the ADC, TIM1 and the other high speed peripherals.
+ *
+ * @return PCLK2 in Hz.
+ */
+uint32_t rccGetPclk2Freq(void);
+
+/**
+ * @brief Gets the clock frequency of the timers on APB1 (TIM2-5).
+ *
+ * The timers run at twice PCLK1 whenever the APB1 prescaler divides.
+ *
+ * @return The APB1 timer clock in Hz.
+ */
+uint32_t rccGetApb1TimerFreq(void);
+
+/**
+ * @brief Gets the clock frequency of the timers on APB2 (TIM1, TIM9-11).
+ *
+ * @return The APB2 timer clock in Hz.
+ */
+uint32_t rccGetApb2TimerFreq(void);
+
 #endif // !RCC_H
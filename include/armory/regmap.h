@@ -0,0 +1,162 @@
+#ifndef REGMAP_H
+#define REGMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c.h"
+
+// Longest burst regmapFlush sends, in data bytes after the register address
+#define REGMAP_MAX_BURST 32
+
+// Clean registers a flush may rewrite to join two dirty runs into one burst.
+// Each costs 9 SCL clocks, a separate burst costs at least 38.
+#define REGMAP_MERGE_GAP 3
+
+// Per-register state flags, kept in the state array of a Regmap
+#define REGMAP_VALID     ( 1 << 0 )  // Cached value matches the device
+#define REGMAP_DIRTY     ( 1 << 1 )  // Cached value still has to be written
+#define REGMAP_VOLATILE  ( 1 << 2 )  // Never cached, always goes to the device
+
+// A shadow copy of a contiguous block of 8-bit device registers.
+//
+// Writes only update the cache and are sent by regmapFlush, which skips
+// registers that did not change and combines neighbouring dirty registers
+// into one auto-increment write. Reads of cached registers never touch the bus.
+typedef struct {
+    I2C_TypeDef *i2c;       // Bus the device is on
+    uint8_t addr;           // 7-bit device address
+    uint8_t base;           // First cached register address
+    uint16_t count;         // Number of cached registers, at most 256 - base
+    uint8_t *cache;         // count bytes, cached register values
+    uint8_t *state;         // count bytes, REGMAP_* flags per register
+} Regmap;
+
+/**
+ * @brief Initializes a register cache.
+ *
+ * Every register starts out invalid, so its first read goes to the device.
+ *
+ * @param map Pointer to the Regmap to initialize.
+ * @param i2c Pointer to the I2C instance the device is on.
+ * @param addr The 7-bit device address.
+ * @param base The first register address to cache.
+ * @param count The number of consecutive registers to cache.
+ * @param cache Storage for count register values.
+ * @param state Storage for count register states.
+ *
+ * @return I2C_OK on success, I2C_ERROR if the arguments are invalid.
+ */
+I2CResult regmapInit(Regmap *map, I2C_TypeDef *i2c, uint8_t addr, uint8_t base,
+        uint16_t count, uint8_t *cache, uint8_t *state);
+
+/**
+ * @brief Marks a register as volatile, or back as cacheable.
+ *
+ * Volatile registers (status flags, FIFOs, data outputs) are read from and
+ * written to the device every time. A write still pending when a register
+ * is made volatile is sent by the next regmapFlush.
+ *
+ * @param map Pointer to the Regmap.
+ * @param reg The register address.
+ * @param isVolatile True to bypass the cache for this register.
+ */
+void regmapSetVolatile(Regmap *map, uint8_t reg, bool isVolatile);
+
+/**
+ * @brief Stores a known register value without touching the device.
+ *
+ * Useful to load the documented reset values after a device reset, so
+ * writes of unchanged defaults are skipped.
+ *
+ * @param map Pointer to the Regmap.
+ * @param reg The register address.
+ * @param value The value the register holds on the device.
+ */
+void regmapSeed(Regmap *map, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Forgets every cached value.
+ *
+ * Pending writes are dropped as well. Call after the device was reset or
+ * power cycled.
+ *
+ * @param map Pointer to the Regmap.
+ */
+void regmapInvalidate(Regmap *map);
+
+/**
+ * @brief Reads every cacheable register from the device.
+ *
+ * Each run of consecutive non-volatile registers is read with
+ * auto-increment reads of at most REGMAP_MAX_BURST bytes. Volatile
+ * registers are never read, as reading them may clear flags or pop data.
+ *
+ * @param map Pointer to the Regmap.
+ *
+ * @return I2CResult of the first failed read, or I2C_OK.
+ *
+ * @note Registers with pending writes keep their cached value.
+ */
+I2CResult regmapRefresh(Regmap *map);
+
+/**
+ * @brief Reads a register, from the cache if possible.
+ *
+ * @param map Pointer to the Regmap.
+ * @param reg The register address.
+ * @param value Pointer to store the register value in.
+ *
+ * @return I2CResult indicating the result of the operation.
+ */
+I2CResult regmapRead(Regmap *map, uint8_t reg, uint8_t *value);
+
+/**
+ * @brief Writes a register through the cache.
+ *
+ * The write is only sent by the next regmapFlush, and is dropped if the
+ * register already holds the value. Volatile registers and registers
+ * outside the cached block are written to the device right away.
+ *
+ * @param map Pointer to the Regmap.
+ * @param reg The register address.
+ * @param value The value to write.
+ *
+ * @return I2CResult indicating the result of the operation.
+ */
+I2CResult regmapWrite(Regmap *map, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Changes some bits of a register.
+ *
+ * Read-modify-write through the cache, so only a cache miss costs a
+ * transaction until the next regmapFlush.
+ *
+ * @param map Pointer to the Regmap.
+ * @param reg The register address.
+ * @param mask The bits to change.
+ * @param value The new value of the bits in mask.
+ *
+ * @return I2CResult indicating the result of the operation.
+ */
+I2CResult regmapUpdateBits(Regmap *map, uint8_t reg, uint8_t mask, uint8_t value);
+
+/**
+ * @brief Sends every pending write to the device.
+ *
+ * Dirty registers are grouped into runs of consecutive addresses, joined
+ * across up to REGMAP_MERGE_GAP clean registers, and each run is sent as one
+ * auto-increment write of at most REGMAP_MAX_BURST bytes.
+ *
+ * @param map Pointer to the Regmap.
+ *
+ * @return I2CResult of the first failed burst, or I2C_OK. Registers of a
+ *         failed burst stay dirty.
+ *
+ * @note The device must increment its register address on multi-byte
+ *       writes. Volatile registers only join a run if they have a write
+ *       pending from before they were made volatile.
+ */
+I2CResult regmapFlush(Regmap *map);
+
+#endif // !REGMAP_H
@@ -0,0 +1,167 @@
+
+#ifndef SH1106_H
+#define SH1106_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c.h"
+#include "font.h"
+
+#define SH1106_ADDR 0x3C
+
+#define SH1106_WIDTH  128
+#define SH1106_HEIGHT 64
+#define SH1106_PAGE_COUNT 8
+
+// Bytes per framebuffer page: the data control byte, then one byte per column
+#define SH1106_PAGE_STRIDE (SH1106_WIDTH + 1)
+
+// Changed columns of a page are sent as spans, one transaction each. A new
+// span costs about 7 bytes of addressing and commands, so clean gaps up to
+// this many columns are resent instead of starting one.
+#define SH1106_SPAN_MERGE_GAP 7
+
+// Most spans sent per page, anything past that joins the last span
+#define SH1106_MAX_SPANS 4
+
+// Column the SH1106 RAM starts at for a 128 pixel wide panel
+#define SH1106_COLUMN_OFFSET 2
+
+// Called from interrupt context once a frame has been sent to the panel
+typedef void (*OledCallback)(void *context);
+
+/**
+ * @brief Initializes an SH1106 display.
+ *
+ * Sends the init sequence, enables DMA on the I2C bus and clears both
+ * framebuffers. The first oledUpdate then clears the panel.
+ *
+ * @param i2c Pointer to the I2C instance the display is on, already set up
+ *            with i2cInit.
+ */
+void oledInit(I2C_TypeDef *i2c);
+
+/**
+ * @brief Starts sending the drawn frame to the panel.
+ *
+ * The back buffer, which all drawing goes to, becomes the front buffer and
+ * the columns that changed are queued on the I2C bus. Each run of changed
+ * columns in a page (joined across gaps of up to SH1106_SPAN_MERGE_GAP) is
+ * one transaction that sets the page and column address and sends just
+ * those bytes. They are moved by DMA while the caller carries on drawing the
+ * next frame into the new back buffer, which starts out as a copy of the
+ * frame being sent.
+ *
+ * @return True if the frame was queued (or nothing had changed), false if
+ *         the previous frame is still being sent. Nothing is lost in that
+ *         case, the changes are sent by a later call. Spans the bus refuses
+ *         or fails to send are marked dirty again and also go out with a
+ *         later call.
+ */
+bool oledUpdate(void);
+
+/**
+ * @brief Checks whether a frame is still being sent to the panel.
+ *
+ * @return True while span transactions of the last frame are running.
+ */
+bool oledIsBusy(void);
+
+/**
+ * @brief Waits until the last frame has been sent to the panel.
+ */
+void oledWait(void);
+
+/**
+ * @brief Sets a function to call each time a frame has been sent.
+ *
+ * @param callback Function to call from interrupt context, or NULL.
+ * @param context User pointer passed to the callback.
+ */
+void oledSetFrameCallback(OledCallback callback, void *context);
+
+/**
+ * @brief Scrolls the whole screen vertically in hardware.
+ *
+ * Moves the display start line, which makes the framebuffer a ring: the
+ * rows that leave one edge of the screen are cleared and come back in at
+ * the other, ready to be drawn on. All drawing coordinates stay relative
+ * to the top of the screen. The next oledUpdate sends the cleared rows
+ * and one start line command, instead of the whole frame.
+ *
+ * @param rows Rows to scroll by, positive moves the content up (new rows
+ *             appear at the bottom), negative moves it down.
+ */
+void oledScroll(int8_t rows);
+
+/**
+ * @brief Gets the framebuffer row shown at the top of the screen.
+ *
+ * @return The display start line (0 - 63).
+ */
+uint8_t oledGetStartLine(void);
+
+void oledDrawPixel(uint8_t x, uint8_t y, bool on);
+
+/**
+ * @brief Sets or clears a filled rectangle in the back buffer.
+ *
+ * Works a page (8 rows) at a time: the rows covered in the top and bottom
+ * pages are masked, every page in between is filled with whole byte stores.
+ * Anything outside the screen is clipped.
+ *
+ * @param x Left column.
+ * @param y Top row.
+ * @param w Width in pixels.
+ * @param h Height in pixels.
+ * @param on True to set the pixels, false to clear them.
+ */
+void oledDrawRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, bool on);
+
+/**
+ * @brief Draws a column-major bitmap into the back buffer.
+ *
+ * The bitmap uses the framebuffer page layout (see Font), so every source
+ * byte lands in at most two page bytes with one shift, whatever the y
+ * position. Set bits are drawn, clear bits leave the framebuffer alone.
+ *
+ * @param x Left column.
+ * @param y Top row.
+ * @param bitmap Pointer to the bitmap, (h + 7) / 8 bytes per column.
+ * @param w Width of the bitmap in columns.
+ * @param h Height of the bitmap in rows.
+ * @param on True to set the bitmap's pixels, false to clear them.
+ */
+void oledDrawBitmap(uint8_t x, uint8_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, bool on);
+
+/**
+ * @brief Draws one character.
+ *
+ * @param x Left column.
+ * @param y Top row.
+ * @param c The character. Characters missing from the font are left blank.
+ * @param font Pointer to the font to use.
+ * @param on True to set the glyph's pixels, false to clear them.
+ *
+ * @return The number of columns to advance for the next character.
+ */
+uint8_t oledDrawChar(uint8_t x, uint8_t y, char c, const Font *font, bool on);
+
+/**
+ * @brief Draws a string on one line.
+ *
+ * Text is drawn over what is already there. Clear the area with
+ * oledDrawRectangle first when replacing text, e.g. a changing score.
+ *
+ * @param x Left column.
+ * @param y Top row.
+ * @param str The null-terminated string.
+ * @param font Pointer to the font to use.
+ * @param on True to set the text's pixels, false to clear them.
+ *
+ * @return The column just past the end of the string.
+ */
+uint16_t oledDrawString(uint8_t x, uint8_t y, const char *str, const Font *font, bool on);
+
+#endif // !SH1106_H
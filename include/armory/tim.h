@@ -45,16 +45,42 @@ typedef struct {
 #define TIM_CR1_CEN     (1 << 0)
 #define TIM_CR1_ARPE    (1 << 7)
 
+// Define TIM CR2 register bit offsets
+#define TIM_CR2_MMS_Pos    4
+#define TIM_CR2_MMS        (0b111 << TIM_CR2_MMS_Pos)
+#define TIM_CR2_MMS_UPDATE (0b010 << TIM_CR2_MMS_Pos) // TRGO on update
+
 // DEFINE TIME CCMR1 register bit offsets
 #define TIM_CCMR1_OC1M_Pos 4
 #define TIM_CCMR1_OC1M     (0b111 << TIM_CCMR1_OC1M_Pos)
 #define TIM_CCMR1_OC1PE    (1 << 3)
+#define TIM_CCMR1_OC2PE    (1 << 11)
+
+// Define TIM CCMR2 register bit offsets
+#define TIM_CCMR2_OC3PE    (1 << 3)
+#define TIM_CCMR2_OC4PE    (1 << 11)
 
 // Define TIM CCER register bit offsets
 #define TIM_CCER_CC1E      (1 << 0)
+#define TIM_CCER_CC2E      (1 << 4)
+#define TIM_CCER_CC3E      (1 << 8)
+#define TIM_CCER_CC4E      (1 << 12)
+
+// Define TIM BDTR register bit offsets
+#define TIM_BDTR_MOE       (1 << 15)
+
+// Define TIM DIER register bit offsets
+#define TIM_DIER_UIE       (1 << 0)
+#define TIM_DIER_CC1IE     (1 << 1)
+#define TIM_DIER_UDE       (1 << 8)
+
+// Define TIM SR register bit offsets
+#define TIM_SR_UIF         (1 << 0)
+#define TIM_SR_CC1IF       (1 << 1)
 
 // Define TIM EGR register bit offsets
 #define TIM_EGR_UG         (1 << 0)
+#define TIM_EGR_CC1G       (1 << 1)
 
 // Typedef for timer channels
 typedef enum {
@@ -65,4 +91,27 @@ typedef enum {
     CH5 = 5
 } TimerChannel;
 
+/**
+ * @brief Enables the clock of a timer.
+ *
+ * @param timer Pointer to the timer (TIM1 - TIM5).
+ */
+void timInit(TIM_TypeDef *timer);
+
+/**
+ * @brief Sets a timer to overflow at a given rate.
+ *
+ * Splits the timer clock over the prescaler and auto-reload, using the
+ * smallest prescaler that fits so the rate is as exact as possible. The
+ * new values are loaded with an update event before returning, the timer
+ * is left stopped with its flags cleared.
+ *
+ * @param timer Pointer to the timer (TIM1 - TIM5), enabled with timInit.
+ * @param rate Overflows per second.
+ *
+ * @return The rate achieved with the timer clock, or 0 if the rate is out
+ *         of range.
+ */
+uint32_t timSetUpdateRate(TIM_TypeDef *timer, uint32_t rate);
+
 #endif // !TIM_H
@@ -3,11 +3,56 @@
 #define TIMING_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define DWT_CTRL    (*(volatile uint32_t*)0xE0001000)
 #define DWT_CYCCNT  (*(volatile uint32_t*)0xE0001004)
 #define DEMCR       (*(volatile uint32_t*)0xE000EDFC)
 
+// A point in time a wait must not run past, measured in DWT cycles.
+// Stored as a start and length so it survives CYCCNT wrapping.
+typedef struct {
+    uint32_t start;
+    uint32_t cycles;
+} Deadline;
+
+/**
+ * @brief Enables the DWT cycle counter.
+ *
+ * Called by every function that relies on the cycle counter, so it only
+ * needs to be called directly before reading DWT_CYCCNT by hand.
+ */
+void timingInit(void);
+
+/**
+ * @brief Converts a time in microseconds to core clock cycles.
+ *
+ * Uses the current HCLK frequency, so stays correct if the clock tree changes.
+ *
+ * @param us The time in microseconds.
+ *
+ * @return The number of DWT cycles in that time.
+ */
+uint32_t timingUsToCycles(uint32_t us);
+
+/**
+ * @brief Creates a deadline a given number of microseconds from now.
+ *
+ * @param us Microseconds until the deadline expires.
+ *
+ * @return The deadline, to be checked with timingExpired.
+ */
+Deadline timingDeadline(uint32_t us);
+
+/**
+ * @brief Checks whether a deadline has passed.
+ *
+ * @param deadline Pointer to the deadline to check.
+ *
+ * @return True once the deadline has expired.
+ */
+bool timingExpired(const Deadline *deadline);
+
 /**
  * @brief Delay the program for a specified number of milliseconds.
  *
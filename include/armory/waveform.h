@@ -0,0 +1,121 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gpio.h"
+
+// TIM1 update requests are served by DMA2 stream 5, channel 6. DMA1 has no
+// path to the AHB1 GPIO ports, and TIM1 is the only timer mapped to DMA2.
+#define WAVEFORM_DMA_STREAM  5
+#define WAVEFORM_DMA_CHANNEL 6
+
+// Priority of the DMA2 stream 5 interrupt
+#ifndef WAVEFORM_IRQ_PRIORITY
+#define WAVEFORM_IRQ_PRIORITY 4
+#endif
+
+// Typedef for how a buffer is played
+typedef enum {
+    WAVEFORM_ONCE = 0,  // Stop after the last sample, which stays on the pins
+    WAVEFORM_LOOP = 1   // Restart from the first sample until stopped
+} WaveformMode;
+
+// Typedef for the events reported to the waveform callback
+typedef enum {
+    WAVEFORM_HALF  = 0, // First half of the buffer sent, it can be refilled
+    WAVEFORM_END   = 1, // Last sample sent, the second half can be refilled
+    WAVEFORM_ERROR = 2  // DMA transfer error, output stopped
+} WaveformEvent;
+
+// Called from the DMA interrupt
+typedef void (*WaveformCallback)(WaveformEvent event, void *context);
+
+/**
+ * @brief Builds a sample that sets and clears pins of a port.
+ *
+ * Samples are written as is to the port's BSRR, so pins outside both masks
+ * are left alone and any number of pins change in the same cycle.
+ *
+ * @param setMask Pins to drive high.
+ * @param clearMask Pins to drive low.
+ *
+ * @return The BSRR word.
+ */
+static inline uint32_t waveformSample(uint16_t setMask, uint16_t clearMask) {
+    return (uint32_t)setMask | ((uint32_t)clearMask << 16);
+}
+
+/**
+ * @brief Converts port values into samples for a set of pins.
+ *
+ * Each sample drives the pins in mask to the matching bits of its value,
+ * e.g. a byte on a parallel bus.
+ *
+ * @param samples Buffer for count samples.
+ * @param values The port values, one per sample.
+ * @param count Number of values.
+ * @param mask The pins the samples drive.
+ */
+void waveformEncode(uint32_t *samples, const uint16_t *values, uint16_t count, uint16_t mask);
+
+/**
+ * @brief Sets the sample rate of the waveform engine.
+ *
+ * Enables DMA2 and TIM1 and sets TIM1 to overflow once per sample. Every
+ * overflow has DMA2 copy the next sample to the port, so the timing does
+ * not depend on the CPU or on interrupts.
+ *
+ * @note TIM1 can't be used for PWM (A8, A9, A10) at the same time.
+ *
+ * @param sampleRate Samples per second, up to a few MHz depending on what
+ *                   else DMA2 and the bus matrix are doing.
+ *
+ * @return The sample rate achieved with the TIM1 clock, or 0 if the rate is
+ *         out of range.
+ */
+uint32_t waveformInit(uint32_t sampleRate);
+
+/**
+ * @brief Starts playing a buffer of samples on a port.
+ *
+ * The first sample is written one sample period after the call. Pins
+ * driven by the samples should be set up as outputs first.
+ *
+ * @param port The GPIO port whose BSRR the samples go to.
+ * @param samples Samples from waveformSample or waveformEncode. Must stay in
+ *                SRAM until the output is stopped.
+ * @param count Number of samples (1 - 65535).
+ * @param mode Whether to stop after the buffer or loop it.
+ *
+ * @return False if a waveform is already playing or the arguments are
+ *         invalid.
+ */
+bool waveformStart(GPIO_TypeDef *port, const uint32_t *samples, uint16_t count, WaveformMode mode);
+
+/**
+ * @brief Stops the output, the pins keep their current level.
+ */
+void waveformStop(void);
+
+/**
+ * @brief Checks whether a waveform is playing.
+ *
+ * @return True until a WAVEFORM_ONCE buffer has finished or the output is
+ *         stopped.
+ */
+bool waveformIsBusy(void);
+
+/**
+ * @brief Sets a function to call on waveform events.
+ *
+ * In WAVEFORM_LOOP mode, WAVEFORM_HALF and WAVEFORM_END allow streaming
+ * longer patterns by refilling the half of the buffer that was just sent.
+ *
+ * @param callback Function to call from interrupt context, or NULL.
+ * @param context User pointer passed to the callback.
+ */
+void waveformSetCallback(WaveformCallback callback, void *context);
+
+#endif // !WAVEFORM_H
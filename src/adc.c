@@ -2,17 +2,54 @@
 #include "armory/adc.h"
 #include "armory/gpio.h"
 #include "armory/rcc.h"
+#include "armory/bitband.h"
+#include "armory/dma.h"
+#include "armory/timing.h"
+#include "armory/tim.h"
+#include "armory/nvic.h"
+
+// What the regular group is doing
+typedef enum {
+    ADC_IDLE,
+    ADC_SCANNING,
+    ADC_STREAMING
+} AdcMode;
+
+static volatile AdcMode mode = ADC_IDLE;
+
+// Regular group being scanned, if any
+static uint8_t scanCount;
+static AdcChannel scanChannels[ADC_MAX_SCAN];
+static volatile uint16_t *scanResults;
+
+// Stream being sampled, if any
+static const AdcStream *activeStream;
+
+// Overruns of the running scan or stream
+static volatile uint32_t overruns;
+
+// Injected group, unused while injectedCount is 0
+static uint8_t injectedCount = 0;
+static AdcInjectedTrigger injectedTrigger;
+static AdcInjectedCallback injectedCallback;
+static void *injectedContext;
+
+// Regular group flags, cleared without touching the injected ones
+#define ADC_SR_REGULAR (ADC_SR_EOC | ADC_SR_STRT | ADC_SR_OVR)
 
 void adcInit(void) {
     // Enable ADC1 clock
-    RCC->APB2ENR |= (1 << 8);
+    bitbandSet(&RCC->APB2ENR, BITBAND_BIT(RCC_APB2ENR_ADC1EN));
 
     // Set ADC prescaler: APB2 / 4 = 21 MHz
-    ADC_CCR &= ~(0b11 << 16);           // Clear prescaler bits
-    ADC_CCR |=  (0b01 << 16);           // DIV4 (0b01)
+    ADC_CCR &= ~ADC_CCR_ADCPRE;              // Clear prescaler bits
+    ADC_CCR |=  (0b01 << ADC_CCR_ADCPRE_Pos); // DIV4 (0b01)
 
     // Set sample time to maximum (480 cycles) for all channels
-    ADC1->SMPR2 = 0xFFFFFFFF;
+    ADC1->SMPR1 = 0x07FFFFFF;
+    ADC1->SMPR2 = 0x3FFFFFFF;
+
+    adcSetResolution(ADC_RESOLUTION_12);
 }
 
 AdcChannel gpioToAdcChannel(Pin pin) {
@@ -26,16 +63,488 @@ uint16_t adcReadPin(Pin pin) {
     return adcReadChannel(gpioToAdcChannel(pin));
 }
 
-uint16_t adcReadChannel(AdcChannel channel) {
+// Turns ADC1 on, waiting out its stabilization time if it was off
+static void adcPowerUp(void) {
+    if(bitbandRead(&ADC1->CR2, BITBAND_BIT(ADC_CR2_ADON))) {
+        return;
+    }
+    bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_ADON));
+    delay_us(3);
+}
+
+// Turns ADC1 off once neither group needs it
+static void adcPowerDown(void) {
+    if(mode == ADC_IDLE && injectedCount == 0) {
+        bitbandClear(&ADC1->CR2, BITBAND_BIT(ADC_CR2_ADON));
+    }
+}
+
+// Waits for a conversion to finish, giving up after ADC_TIMEOUT_US
+static bool adcWaitFlag(uint32_t flag) {
+    Deadline deadline = timingDeadline(ADC_TIMEOUT_US);
+
+    while(!(ADC1->SR & flag)) {
+        if(timingExpired(&deadline)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Reads one channel through the injected group, which interrupts the
+// regular group's conversions instead of waiting for them
+static bool adcReadInjectedOnce(AdcChannel channel, uint16_t *value) {
+    if(injectedCount != 0) {
+        return false;
+    }
+
+    // A single channel sits in JSQ4
+    ADC1->JSQR = (uint32_t)channel << 15;
+    ADC1->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+    bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_JSWSTART));
+    bool done = adcWaitFlag(ADC_SR_JEOC);
+    ADC1->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+
+    if(!done) {
+        return false;
+    }
+
+    *value = ADC1->JDR1 & 0x0FFF;
+    return true;
+}
+
+// Programs the regular sequence, 6 channels in SQR3, 6 in SQR2, 4 in SQR1
+static void adcSetSequence(const AdcChannel channels[], uint8_t count) {
+    uint32_t sqr[3] = { 0, 0, (uint32_t)(count - 1) << ADC_SQR1_L_Pos };
+
+    for(uint8_t i = 0; i < count; i++) {
+        sqr[i / 6] |= (uint32_t)channels[i] << ((i % 6) * 5);
+    }
+
+    ADC1->SQR3 = sqr[0];
+    ADC1->SQR2 = sqr[1];
+    ADC1->SQR1 = sqr[2];
+}
+
+bool adcTryReadChannel(AdcChannel channel, uint16_t *value) {
     if(channel == ADC_INVALID || channel > 15) {
-        return 0; // Invalid channel
+        return false; // Invalid channel
+    }
+
+    // The ADC is busy, hand out the latest scan result if there is one
+    if(mode == ADC_SCANNING) {
+        for(uint8_t i = 0; i < scanCount; i++) {
+            if(scanChannels[i] == channel) {
+                *value = scanResults[i];
+                return true;
+            }
+        }
+    }
+    if(mode != ADC_IDLE) {
+        return adcReadInjectedOnce(channel, value);
+    }
+
+    adcSetSequence(&channel, 1);
+    adcPowerUp();
+    bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_SWSTART));
+    bool done = adcWaitFlag(ADC_SR_EOC);
+    adcPowerDown();
+
+    if(!done) {
+        return false;
+    }
+
+    *value = ADC1->DR & 0x0FFF;
+    return true;
+}
+
+uint16_t adcReadChannel(AdcChannel channel) {
+    uint16_t value;
+
+    if(!adcTryReadChannel(channel, &value)) {
+        return ADC_READ_ERROR;
+    }
+
+    return value;
+}
+
+// Sample time field of a channel, SMPR2 holds channels 0-9
+static volatile uint32_t *adcSampleTimeReg(AdcChannel channel, uint8_t *shift) {
+    if(channel < 10) {
+        *shift = channel * ADC_SMPR_BITS;
+        return &ADC1->SMPR2;
+    }
+    *shift = (channel - 10) * ADC_SMPR_BITS;
+    return &ADC1->SMPR1;
+}
+
+void adcSetSampleTime(AdcChannel channel, AdcSampleTime time) {
+    if(channel > 15) {
+        return;
+    }
+
+    uint8_t shift;
+    volatile uint32_t *smpr = adcSampleTimeReg(channel, &shift);
+    *smpr = (*smpr & ~(ADC_SMPR_MASK << shift)) | ((uint32_t)time << shift);
+}
+
+void adcSetResolution(AdcResolution resolution) {
+    ADC1->CR1 = (ADC1->CR1 & ~ADC_CR1_RES) | ((uint32_t)resolution << ADC_CR1_RES_Pos);
+}
+
+uint32_t adcGetClockFreq(void) {
+    uint32_t adcpre = (ADC_CCR & ADC_CCR_ADCPRE) >> ADC_CCR_ADCPRE_Pos;
+    return rccGetPclk2Freq() / (2 * (adcpre + 1));
+}
+
+uint32_t adcGetConversionCycles(AdcChannel channel) {
+    // Sampling cycles for each AdcSampleTime
+    static const uint16_t sampleCycles[8] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+
+    if(channel > 15) {
+        return 0;
     }
 
-    ADC1->SQR3 = channel;
-    ADC1->CR2 |= ADC_CR2_ADON;
-    ADC1->CR2 |= ADC_CR2_SWSTART;
-    while (!(ADC1->SR & ADC_SR_EOC));
-    ADC1->CR2 &= ~(ADC_CR2_ADON);
-    return ADC1->DR & 0x0FFF;
+    uint8_t shift;
+    volatile uint32_t *smpr = adcSampleTimeReg(channel, &shift);
+    uint32_t time = (*smpr >> shift) & ADC_SMPR_MASK;
+
+    // 12 cycles of conversion at 12 bits, two less per resolution step
+    uint32_t resolution = (ADC1->CR1 & ADC_CR1_RES) >> ADC_CR1_RES_Pos;
+    return sampleCycles[time] + 12 - 2 * resolution;
+}
+
+uint32_t adcGetConversionTimeNs(AdcChannel channel) {
+    // At most 492 cycles, so cycles * 10^6 stays within 32 bits
+    return adcGetConversionCycles(channel) * 1000000U / (adcGetClockFreq() / 1000);
+}
+
+uint32_t adcGetMaxSampleRate(const AdcChannel channels[], uint8_t count) {
+    uint32_t cycles = 0;
 
+    for(uint8_t i = 0; i < count; i++) {
+        cycles += adcGetConversionCycles(channels[i]);
+    }
+
+    if(cycles == 0) {
+        return 0;
+    }
+    return adcGetClockFreq() / cycles;
+
+}
+
+// Points DMA2 stream 0 at ADC1->DR, filling count halfwords in a circle
+static DMA_Stream_TypeDef *adcSetupDma(volatile uint16_t *buffer, uint16_t count) {
+    dmaInit(DMA2);
+    DMA_Stream_TypeDef *s = dmaGetStream(DMA2, ADC_DMA_STREAM);
+    dmaDisableStream(DMA2, ADC_DMA_STREAM);
+    dmaClearFlags(DMA2, ADC_DMA_STREAM, DMA_FLAG_ALL);
+
+    s->PAR = (uint32_t)&ADC1->DR;
+    s->M0AR = (uint32_t)buffer;
+    s->NDTR = count;
+    s->FCR = 0;
+    s->CR = (ADC_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+        | (0b10U << DMA_SxCR_PL_Pos)
+        | (DMA_SIZE_HALFWORD << DMA_SxCR_MSIZE_Pos)
+        | (DMA_SIZE_HALFWORD << DMA_SxCR_PSIZE_Pos)
+        | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_P2M;
+
+    return s;
+}
+
+// Enables the ADC interrupt, shared by the injected group and the overrun
+// recovery of the regular group
+static void adcEnableIrq(void) {
+    nvicSetPriority(ADC_IRQn, ADC_INJECTED_IRQ_PRIORITY);
+    nvicEnableIrq(ADC_IRQn);
+}
+
+// Watches a scan or stream for overruns, which would stop its DMA requests
+static void adcStartOverrunRecovery(void) {
+    overruns = 0;
+    ADC1->SR = ~ADC_SR_OVR;
+    bitbandSet(&ADC1->CR1, BITBAND_BIT(ADC_CR1_OVRIE));
+    adcEnableIrq();
+}
+
+// A conversion finished before DMA took the one before it. ADC1 stops making
+// DMA requests until the DMA is restarted and the regular group is started
+// again, so both begin from the first sample of the buffer.
+static void adcRecoverOverrun(void) {
+    overruns++;
+
+    DMA_Stream_TypeDef *s = dmaGetStream(DMA2, ADC_DMA_STREAM);
+    dmaDisableStream(DMA2, ADC_DMA_STREAM);
+    dmaClearFlags(DMA2, ADC_DMA_STREAM, DMA_FLAG_ALL);
+    s->NDTR = (mode == ADC_STREAMING) ? activeStream->blockLength * 2 : scanCount;
+
+    // Toggling DMA resets the request logic
+    bitbandClear(&ADC1->CR2, BITBAND_BIT(ADC_CR2_DMA));
+    ADC1->SR = ~ADC_SR_REGULAR;
+    bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_DMA));
+    bitbandSet(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+
+    // A stream carries on from the next trigger
+    if(mode == ADC_SCANNING) {
+        bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_SWSTART));
+    }
+}
+
+// Stops conversions and DMA of the regular group and powers ADC1 down
+// unless the injected group still needs it
+static void adcStopRegular(void) {
+    ADC1->CR2 &= ~(ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN);
+    bitbandClear(&ADC1->CR1, BITBAND_BIT(ADC_CR1_OVRIE));
+    bitbandWrite(&ADC1->CR1, BITBAND_BIT(ADC_CR1_SCAN), injectedCount > 1);
+    dmaDisableStream(DMA2, ADC_DMA_STREAM);
+    mode = ADC_IDLE;
+    if(injectedCount == 0) {
+        nvicDisableIrq(ADC_IRQn);
+    }
+    adcPowerDown();
+}
+
+bool adcScanStart(const AdcChannel channels[], uint8_t count, volatile uint16_t *results) {
+    if(mode != ADC_IDLE || count == 0 || count > ADC_MAX_SCAN || results == NULL) {
+        return false;
+    }
+
+    for(uint8_t i = 0; i < count; i++) {
+        if(channels[i] > 15) {
+            return false;
+        }
+        scanChannels[i] = channels[i];
+    }
+    scanCount = count;
+    scanResults = results;
+
+    // One halfword per channel, wrapping back to results[0] after the last
+    DMA_Stream_TypeDef *s = adcSetupDma(results, count);
+    bitbandSet(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+
+    adcSetSequence(channels, count);
+    bitbandSet(&ADC1->CR1, BITBAND_BIT(ADC_CR1_SCAN));
+    ADC1->CR2 |= ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS;
+    ADC1->SR = ~ADC_SR_REGULAR;
+
+    mode = ADC_SCANNING;
+    adcStartOverrunRecovery();
+    adcPowerUp();
+    bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_SWSTART));
+
+    return true;
+}
+
+void adcScanStop(void) {
+    if(mode == ADC_SCANNING) {
+        adcStopRegular();
+    }
+}
+
+bool adcIsScanning(void) {
+    return mode == ADC_SCANNING;
+}
+
+uint32_t adcGetOverruns(void) {
+    return overruns;
+}
+
+static TIM_TypeDef *adcTriggerTimer(AdcTrigger trigger) {
+    return (trigger == ADC_TRIGGER_TIM3) ? TIM3 : TIM2;
+}
+
+// Hands the block DMA has just finished to the stream callback
+static void adcStreamDmaHandler(uint32_t flags, void *context) {
+    const AdcStream *stream = context;
+
+    if(flags & DMA_FLAG_TE) {
+        adcStreamStop();
+        return;
+    }
+
+    if(flags & DMA_FLAG_HT) {
+        stream->callback(stream->buffer, stream->blockLength, stream->context);
+    }
+    if(flags & DMA_FLAG_TC) {
+        stream->callback(stream->buffer + stream->blockLength, stream->blockLength, stream->context);
+    }
+}
+
+uint32_t adcStreamStart(const AdcStream *stream) {
+    if(mode != ADC_IDLE || stream == NULL || stream->buffer == NULL || stream->callback == NULL) {
+        return 0;
+    }
+    if(stream->count == 0 || stream->count > ADC_MAX_SCAN) {
+        return 0;
+    }
+    if(stream->blockLength == 0 || stream->blockLength % stream->count != 0
+            || stream->blockLength > 0x7FFF) {
+        return 0;
+    }
+    if(stream->trigger != ADC_TRIGGER_TIM2 && stream->trigger != ADC_TRIGGER_TIM3) {
+        return 0;
+    }
+    for(uint8_t i = 0; i < stream->count; i++) {
+        if(stream->channels[i] > 15) {
+            return 0;
+        }
+    }
+
+    if(stream->sampleRate > adcGetMaxSampleRate(stream->channels, stream->count)) {
+        return 0;
+    }
+
+    TIM_TypeDef *timer = adcTriggerTimer(stream->trigger);
+    timInit(timer);
+    uint32_t rate = timSetUpdateRate(timer, stream->sampleRate);
+    if(rate == 0) {
+        return 0;
+    }
+    timer->CR2 = (timer->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_UPDATE;
+
+    // Both blocks in one circular transfer, half and full mark each block
+    DMA_Stream_TypeDef *s = adcSetupDma(stream->buffer, stream->blockLength * 2);
+    s->CR |= DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    activeStream = stream;
+    nvicSetPriority(DMA2_Stream0_IRQn, ADC_IRQ_PRIORITY);
+    dmaSetCallback(DMA2, ADC_DMA_STREAM, adcStreamDmaHandler, (void *)stream);
+    bitbandSet(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+
+    // One pass over the channels per rising edge of TRGO
+    adcSetSequence(stream->channels, stream->count);
+    bitbandWrite(&ADC1->CR1, BITBAND_BIT(ADC_CR1_SCAN), stream->count > 1 || injectedCount > 1);
+    ADC1->CR2 = (ADC1->CR2 & ~(ADC_CR2_CONT | ADC_CR2_EXTSEL | ADC_CR2_EXTEN))
+        | ADC_CR2_DMA | ADC_CR2_DDS
+        | ((uint32_t)stream->trigger << ADC_CR2_EXTSEL_Pos)
+        | (0b01U << ADC_CR2_EXTEN_Pos);
+    ADC1->SR = ~ADC_SR_REGULAR;
+
+    mode = ADC_STREAMING;
+    adcStartOverrunRecovery();
+    adcPowerUp();
+    bitbandSet(&timer->CR1, BITBAND_BIT(TIM_CR1_CEN));
+
+    return rate;
+}
+
+void adcStreamStop(void) {
+    if(mode != ADC_STREAMING) {
+        return;
+    }
+
+    bitbandClear(&adcTriggerTimer(activeStream->trigger)->CR1, BITBAND_BIT(TIM_CR1_CEN));
+    adcStopRegular();
+    dmaSetCallback(DMA2, ADC_DMA_STREAM, NULL, NULL);
+}
+
+bool adcInjectedInit(const AdcChannel channels[], uint8_t count, AdcInjectedTrigger trigger,
+        AdcInjectedCallback callback, void *context) {
+    if(count == 0 || count > ADC_MAX_INJECTED) {
+        return false;
+    }
+    if(trigger != ADC_INJECTED_SOFTWARE && trigger > ADC_INJECTED_TIM4_TRGO) {
+        return false;
+    }
+
+    // Channels fill the end of the sequence, JSQ4 is always converted last
+    uint32_t jsqr = (uint32_t)(count - 1) << ADC_JSQR_JL_Pos;
+    for(uint8_t i = 0; i < count; i++) {
+        if(channels[i] > 15) {
+            return false;
+        }
+        jsqr |= (uint32_t)channels[i] << ((ADC_MAX_INJECTED - count + i) * 5);
+    }
+
+    // Keep the old group quiet while it is replaced
+    nvicDisableIrq(ADC_IRQn);
+    ADC1->CR2 &= ~ADC_CR2_JEXTEN;
+
+    ADC1->JSQR = jsqr;
+    injectedCount = count;
+    injectedTrigger = trigger;
+    injectedCallback = callback;
+    injectedContext = context;
+
+    // Groups of more than one channel are only converted in scan mode
+    if(count > 1) {
+        bitbandSet(&ADC1->CR1, BITBAND_BIT(ADC_CR1_SCAN));
+    }
+
+    ADC1->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+    bitbandSet(&ADC1->CR1, BITBAND_BIT(ADC_CR1_JEOCIE));
+    adcPowerUp();
+
+    nvicClearPending(ADC_IRQn);
+    adcEnableIrq();
+
+    if(trigger != ADC_INJECTED_SOFTWARE) {
+        ADC1->CR2 = (ADC1->CR2 & ~(ADC_CR2_JEXTSEL | ADC_CR2_JEXTEN))
+            | ((uint32_t)trigger << ADC_CR2_JEXTSEL_Pos)
+            | (0b01U << ADC_CR2_JEXTEN_Pos);
+    }
+
+    return true;
+}
+
+bool adcInjectedStart(void) {
+    if(injectedCount == 0 || injectedTrigger != ADC_INJECTED_SOFTWARE) {
+        return false;
+    }
+
+    bitbandSet(&ADC1->CR2, BITBAND_BIT(ADC_CR2_JSWSTART));
+    return true;
+}
+
+uint16_t adcInjectedRead(uint8_t index) {
+    if(index >= injectedCount) {
+        return ADC_READ_ERROR;
+    }
+
+    // JDR1-4 follow each other
+    return (&ADC1->JDR1)[index] & 0x0FFF;
+}
+
+void adcInjectedStop(void) {
+    if(injectedCount == 0) {
+        return;
+    }
+
+    ADC1->CR2 &= ~ADC_CR2_JEXTEN;
+    bitbandClear(&ADC1->CR1, BITBAND_BIT(ADC_CR1_JEOCIE));
+
+    // The regular group still needs the interrupt for overruns
+    if(mode == ADC_IDLE) {
+        nvicDisableIrq(ADC_IRQn);
+    }
+
+    injectedCount = 0;
+    if(mode == ADC_IDLE) {
+        bitbandClear(&ADC1->CR1, BITBAND_BIT(ADC_CR1_SCAN));
+    }
+    adcPowerDown();
+}
+
+void ADC_IRQHandler(void) {
+    uint32_t sr = ADC1->SR;
+
+    if((sr & ADC_SR_OVR) && mode != ADC_IDLE) {
+        adcRecoverOverrun();
+    }
+
+    // Without an injected group, JEOC belongs to a one-off read polling it
+    if(!(sr & ADC_SR_JEOC) || injectedCount == 0) {
+        return;
+    }
+    ADC1->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+
+    uint16_t results[ADC_MAX_INJECTED];
+    for(uint8_t i = 0; i < injectedCount; i++) {
+        results[i] = (&ADC1->JDR1)[i] & 0x0FFF;
+    }
+
+    if(injectedCallback) {
+        injectedCallback(results, injectedCount, injectedContext);
+    }
 }
@@ -0,0 +1,150 @@
+#include "armory/dma.h"
+#include "armory/nvic.h"
+#include "armory/rcc.h"
+#include "armory/bitband.h"
+
+// Callback registered for each stream of DMA1 and DMA2
+typedef struct {
+    DmaCallback callback;
+    void *context;
+} DmaHandler;
+
+static DmaHandler dmaHandlers[2][8];
+
+static const IRQn dmaIrqs[2][8] = {
+    {
+        DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+        DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn
+    },
+    {
+        DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+        DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn
+    }
+};
+
+// Bit offset of each stream's flags within LISR/HISR (and LIFCR/HIFCR)
+static const uint8_t dmaFlagShift[4] = { 0, 6, 16, 22 };
+
+void dmaInit(DMA_TypeDef *dma) {
+    if(dma == DMA1) {
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_DMA1EN));
+    } else if(dma == DMA2) {
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_DMA2EN));
+    }
+}
+
+DMA_Stream_TypeDef *dmaGetStream(DMA_TypeDef *dma, uint8_t stream) {
+    return &dma->STREAM[stream & 0x07];
+}
+
+void dmaDisableStream(DMA_TypeDef *dma, uint8_t stream) {
+    DMA_Stream_TypeDef *s = dmaGetStream(dma, stream);
+
+    bitbandClear(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+    // The current transfer finishes before EN reads back as 0
+    while(s->CR & DMA_SxCR_EN);
+}
+
+uint32_t dmaGetFlags(DMA_TypeDef *dma, uint8_t stream) {
+    // Streams 0-3 live in LISR, 4-7 in HISR
+    uint32_t isr = (stream < 4) ? dma->LISR : dma->HISR;
+    return (isr >> dmaFlagShift[stream & 0x03]) & DMA_FLAG_ALL;
+}
+
+void dmaClearFlags(DMA_TypeDef *dma, uint8_t stream, uint32_t flags) {
+    uint32_t mask = (flags & DMA_FLAG_ALL) << dmaFlagShift[stream & 0x03];
+
+    if(stream < 4) {
+        dma->LIFCR = mask;
+    } else {
+        dma->HIFCR = mask;
+    }
+}
+
+void dmaSetCallback(DMA_TypeDef *dma, uint8_t stream, DmaCallback callback, void *context) {
+    int index = (dma == DMA2) ? 1 : 0;
+
+    dmaHandlers[index][stream & 0x07].callback = callback;
+    dmaHandlers[index][stream & 0x07].context = context;
+
+    if(callback) {
+        nvicEnableIrq(dmaIrqs[index][stream & 0x07]);
+    } else {
+        nvicDisableIrq(dmaIrqs[index][stream & 0x07]);
+    }
+}
+
+static void dmaIrqHandler(DMA_TypeDef *dma, int index, uint8_t stream) {
+    // Acknowledge the flags before handing them to the callback
+    uint32_t flags = dmaGetFlags(dma, stream);
+    dmaClearFlags(dma, stream, flags);
+
+    DmaHandler *handler = &dmaHandlers[index][stream];
+    if(handler->callback) {
+        handler->callback(flags, handler->context);
+    }
+}
+
+void DMA1_Stream0_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 0);
+}
+
+void DMA1_Stream1_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 1);
+}
+
+void DMA1_Stream2_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 2);
+}
+
+void DMA1_Stream3_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 3);
+}
+
+void DMA1_Stream4_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 4);
+}
+
+void DMA1_Stream5_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 5);
+}
+
+void DMA1_Stream6_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 6);
+}
+
+void DMA1_Stream7_IRQHandler(void) {
+    dmaIrqHandler(DMA1, 0, 7);
+}
+
+void DMA2_Stream0_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 0);
+}
+
+void DMA2_Stream1_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 1);
+}
+
+void DMA2_Stream2_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 2);
+}
+
+void DMA2_Stream3_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 3);
+}
+
+void DMA2_Stream4_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 4);
+}
+
+void DMA2_Stream5_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 5);
+}
+
+void DMA2_Stream6_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 6);
+}
+
+void DMA2_Stream7_IRQHandler(void) {
+    dmaIrqHandler(DMA2, 1, 7);
+}
@@ -0,0 +1,290 @@
+#include "armory/exti.h"
+#include "armory/nvic.h"
+#include "armory/rcc.h"
+#include "armory/tim.h"
+#include "armory/bitband.h"
+
+typedef struct {
+    GPIO_TypeDef *port;     // NULL while the line is free
+    ExtiCallback callback;
+    void *context;
+    ExtiEdge edge;
+    uint32_t debounceUs;
+    uint32_t due;           // TIM5 count the pin is sampled at
+    bool settling;
+    PinState level;         // Last settled level
+} ExtiLine;
+
+static ExtiLine lines[EXTI_LINE_COUNT];
+
+static bool debounceTimerReady = false;
+
+static IRQn extiIrq(uint8_t line) {
+    if(line < 5) {
+        return (IRQn)(EXTI0_IRQn + line);
+    } else if(line < 10) {
+        return EXTI9_5_IRQn;
+    }
+    return EXTI15_10_IRQn;
+}
+
+// Starts TIM5 as a free running 32 bit microsecond counter. Compare channel 1
+// is moved to whichever settling line is due first.
+static void extiInitDebounceTimer(void) {
+    if(debounceTimerReady) {
+        return;
+    }
+
+    timInit(TIM5);
+
+    TIM5->CR1 = 0;
+    TIM5->DIER = 0;
+    TIM5->PSC = rccGetApb1TimerFreq() / EXTI_DEBOUNCE_TIMER_HZ - 1;
+    TIM5->ARR = 0xFFFFFFFF;
+    TIM5->CNT = 0;
+
+    // Load the prescaler, then drop the flags the update set
+    TIM5->EGR = TIM_EGR_UG;
+    TIM5->SR = 0;
+    TIM5->CR1 = TIM_CR1_CEN;
+
+    nvicSetPriority(TIM5_IRQn, EXTI_IRQ_PRIORITY);
+    nvicEnableIrq(TIM5_IRQn);
+
+    debounceTimerReady = true;
+}
+
+// Points the compare at the next line to settle, or stops the interrupt
+// when none are left
+static void extiArmDebounceTimer(void) {
+    uint32_t now = TIM5->CNT;
+    int32_t soonest = INT32_MAX;
+    bool any = false;
+
+    for(int i = 0; i < EXTI_LINE_COUNT; i++) {
+        if(!lines[i].settling) {
+            continue;
+        }
+
+        int32_t remaining = (int32_t)(lines[i].due - now);
+        if(remaining < soonest) {
+            soonest = remaining;
+        }
+        any = true;
+    }
+
+    if(!any) {
+        bitbandClear(&TIM5->DIER, BITBAND_BIT(TIM_DIER_CC1IE));
+        return;
+    }
+
+    TIM5->CCR1 = now + soonest;
+    TIM5->SR = ~TIM_SR_CC1IF;
+    bitbandSet(&TIM5->DIER, BITBAND_BIT(TIM_DIER_CC1IE));
+
+    // The compare only fires on an exact match, so force the event if the
+    // counter is already at or past it
+    if((int32_t)(TIM5->CNT - (now + soonest)) >= 0) {
+        TIM5->EGR = TIM_EGR_CC1G;
+    }
+}
+
+// Starts the settling time of a line, its edges are ignored until then
+static void extiStartSettling(uint8_t line) {
+    bitbandClear(&EXTI->IMR, line);
+    lines[line].due = TIM5->CNT + lines[line].debounceUs;
+    lines[line].settling = true;
+}
+
+// Reports a line's new level if it is one of the edges being watched
+static void extiReport(uint8_t line, PinState level) {
+    ExtiLine *l = &lines[line];
+    ExtiEdge edge = (level == HIGH) ? EXTI_RISING : EXTI_FALLING;
+
+    if(l->edge & edge) {
+        l->callback((Pin){ l->port, line }, level, l->context);
+    }
+}
+
+// Samples a line whose settling time is over and listens for edges again
+static void extiSettle(uint8_t line) {
+    ExtiLine *l = &lines[line];
+    PinState level = gpioReadFast((Pin){ l->port, line });
+
+    l->settling = false;
+    if(level != l->level) {
+        l->level = level;
+        extiReport(line, level);
+    }
+
+    // Bounces while masked still latched the pending bit
+    EXTI->PR = PIN_MASK(line);
+    bitbandSet(&EXTI->IMR, line);
+
+    // The callback may have detached the line
+    if(l->port == NULL) {
+        bitbandClear(&EXTI->IMR, line);
+        return;
+    }
+
+    // An edge between the sample and unmasking would otherwise be lost
+    if(gpioReadFast((Pin){ l->port, line }) != l->level) {
+        extiStartSettling(line);
+    }
+}
+
+static void extiHandleLines(uint32_t mask) {
+    uint32_t pending = EXTI->PR & EXTI->IMR & mask;
+
+    for(uint8_t line = 0; line < EXTI_LINE_COUNT; line++) {
+        if(!(pending & PIN_MASK(line))) {
+            continue;
+        }
+
+        EXTI->PR = PIN_MASK(line);
+
+        ExtiLine *l = &lines[line];
+        if(l->port == NULL) {
+            continue;
+        }
+
+        if(l->debounceUs == 0) {
+            // Only the watched edges are enabled, so the edge gives the level
+            // unless both are
+            PinState level = (l->edge == EXTI_RISING) ? HIGH : LOW;
+            if(l->edge == EXTI_BOTH) {
+                level = gpioReadFast((Pin){ l->port, line });
+            }
+            l->level = level;
+            l->callback((Pin){ l->port, line }, level, l->context);
+        } else {
+            extiStartSettling(line);
+        }
+    }
+
+    extiArmDebounceTimer();
+}
+
+bool extiAttach(Pin pin, ExtiEdge edge, uint32_t debounceUs, ExtiCallback callback, void *context) {
+    if(pin.port == NULL || pin.pin >= EXTI_LINE_COUNT || callback == NULL) {
+        return false;
+    }
+
+    uint8_t line = pin.pin;
+    if(lines[line].port != NULL && lines[line].port != pin.port) {
+        return false;
+    }
+
+    bitbandSet(&RCC->APB2ENR, BITBAND_BIT(RCC_APB2ENR_SYSCFGEN));
+    if(debounceUs > 0) {
+        extiInitDebounceTimer();
+    }
+
+    uint32_t primask = nvicEnterCritical();
+
+    bitbandClear(&EXTI->IMR, line);
+
+    // Route the line to the pin's port, ports are 0x400 apart from GPIOA
+    uint32_t portIndex = ((uint32_t)pin.port - GPIOA_BASE) >> 10;
+    uint8_t shift = (line & 0x03) * 4;
+    SYSCFG->EXTICR[line >> 2] &= ~(0x0F << shift);
+    SYSCFG->EXTICR[line >> 2] |= (portIndex << shift);
+
+    lines[line].port = pin.port;
+    lines[line].callback = callback;
+    lines[line].context = context;
+    lines[line].edge = edge;
+    lines[line].debounceUs = debounceUs;
+    lines[line].settling = false;
+    lines[line].level = gpioReadFast(pin);
+
+    // Debouncing follows every change of the pin, the edge is picked once
+    // it has settled
+    bool rising = (debounceUs > 0) || (edge & EXTI_RISING);
+    bool falling = (debounceUs > 0) || (edge & EXTI_FALLING);
+
+    if(rising) {
+        bitbandSet(&EXTI->RTSR, line);
+    } else {
+        bitbandClear(&EXTI->RTSR, line);
+    }
+
+    if(falling) {
+        bitbandSet(&EXTI->FTSR, line);
+    } else {
+        bitbandClear(&EXTI->FTSR, line);
+    }
+
+    EXTI->PR = PIN_MASK(line);
+    bitbandSet(&EXTI->IMR, line);
+
+    nvicExitCritical(primask);
+
+    nvicSetPriority(extiIrq(line), EXTI_IRQ_PRIORITY);
+    nvicEnableIrq(extiIrq(line));
+
+    return true;
+}
+
+void extiDetach(Pin pin) {
+    if(pin.pin >= EXTI_LINE_COUNT || lines[pin.pin].port != pin.port) {
+        return;
+    }
+
+    uint8_t line = pin.pin;
+    uint32_t primask = nvicEnterCritical();
+
+    bitbandClear(&EXTI->IMR, line);
+    bitbandClear(&EXTI->RTSR, line);
+    bitbandClear(&EXTI->FTSR, line);
+    EXTI->PR = PIN_MASK(line);
+
+    lines[line].port = NULL;
+    lines[line].settling = false;
+
+    nvicExitCritical(primask);
+}
+
+void EXTI0_IRQHandler(void) {
+    extiHandleLines(PIN_MASK(0));
+}
+
+void EXTI1_IRQHandler(void) {
+    extiHandleLines(PIN_MASK(1));
+}
+
+void EXTI2_IRQHandler(void) {
+    extiHandleLines(PIN_MASK(2));
+}
+
+void EXTI3_IRQHandler(void) {
+    extiHandleLines(PIN_MASK(3));
+}
+
+void EXTI4_IRQHandler(void) {
+    extiHandleLines(PIN_MASK(4));
+}
+
+void EXTI9_5_IRQHandler(void) {
+    extiHandleLines(0x03E0);
+}
+
+void EXTI15_10_IRQHandler(void) {
+    extiHandleLines(0xFC00);
+}
+
+void TIM5_IRQHandler(void) {
+    if(!(TIM5->SR & TIM_SR_CC1IF)) {
+        return;
+    }
+    TIM5->SR = ~TIM_SR_CC1IF;
+
+    uint32_t now = TIM5->CNT;
+    for(uint8_t line = 0; line < EXTI_LINE_COUNT; line++) {
+        if(lines[line].settling && (int32_t)(now - lines[line].due) >= 0) {
+            extiSettle(line);
+        }
+    }
+
+    extiArmDebounceTimer();
+}
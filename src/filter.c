@@ -0,0 +1,185 @@
+#include "armory/filter.h"
+
+#include <stddef.h>
+
+// Two samples per word, allowed to alias the uint16_t blocks
+typedef uint32_t __attribute__((may_alias)) FilterPair;
+
+// Adds 1 to both halves of a word through SMLAD
+#define FILTER_ONES 0x00010001U
+
+#if defined(__ARM_FEATURE_DSP)
+
+// Adds the signed halves of two words separately
+static inline __attribute__((always_inline)) uint32_t filterSadd16(uint32_t a, uint32_t b) {
+    uint32_t result;
+    __asm__ ("sadd16 %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+}
+
+// Subtracts the signed halves of two words separately
+static inline __attribute__((always_inline)) uint32_t filterSsub16(uint32_t a, uint32_t b) {
+    uint32_t result;
+    __asm__ ("ssub16 %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+}
+
+// Multiplies the signed halves of two words pairwise and adds both
+// products to an accumulator
+static inline __attribute__((always_inline)) int32_t filterSmlad(uint32_t a, uint32_t b, int32_t acc) {
+    int32_t result;
+    __asm__ ("smlad %0, %1, %2, %3" : "=r" (result) : "r" (a), "r" (b), "r" (acc));
+    return result;
+}
+
+#else
+
+// Plain C versions for cores without the DSP extension
+
+static inline uint32_t filterSadd16(uint32_t a, uint32_t b) {
+    uint16_t lo = (uint16_t)((int16_t)a + (int16_t)b);
+    uint16_t hi = (uint16_t)((int16_t)(a >> 16) + (int16_t)(b >> 16));
+    return lo | ((uint32_t)hi << 16);
+}
+
+static inline uint32_t filterSsub16(uint32_t a, uint32_t b) {
+    uint16_t lo = (uint16_t)((int16_t)a - (int16_t)b);
+    uint16_t hi = (uint16_t)((int16_t)(a >> 16) - (int16_t)(b >> 16));
+    return lo | ((uint32_t)hi << 16);
+}
+
+static inline int32_t filterSmlad(uint32_t a, uint32_t b, int32_t acc) {
+    return acc + (int16_t)a * (int16_t)b + (int16_t)(a >> 16) * (int16_t)(b >> 16);
+}
+
+#endif
+
+uint16_t filterDecimate(const uint16_t *in, uint16_t length, uint8_t factorLog2, uint8_t extraBits, uint16_t *out) {
+    // Past factorLog2 / 2 extra bits the outputs would only carry noise, and
+    // 12 + extraBits would no longer fit in 16 bits
+    if(factorLog2 < 1 || factorLog2 > 8 || extraBits > factorLog2 / 2) {
+        return 0;
+    }
+
+    const FilterPair *pairs = (const FilterPair *)in;
+    uint16_t pairsPerOutput = (1U << factorLog2) / 2;
+    uint16_t outputs = length >> factorLog2;
+    uint8_t shift = factorLog2 - extraBits;
+
+    for(uint16_t i = 0; i < outputs; i++) {
+        int32_t sum = 0;
+        uint16_t left = pairsPerOutput;
+
+        // 8 pairs of 12 bit samples fill a signed half without overflow, so
+        // the halves are summed in chunks of 8 and folded with one SMLAD
+        while(left > 0) {
+            uint16_t chunk = (left > 8) ? 8 : left;
+            uint32_t halves = 0;
+
+            for(uint16_t j = 0; j < chunk; j++) {
+                halves = filterSadd16(halves, *pairs++);
+            }
+            sum = filterSmlad(halves, FILTER_ONES, sum);
+            left -= chunk;
+        }
+
+        out[i] = (uint16_t)(sum >> shift);
+    }
+
+    return outputs;
+}
+
+bool filterMovingAverageInit(MovingAverage *f, uint16_t *history, uint16_t window) {
+    if(history == NULL || window < 2 || window > FILTER_MAX_WINDOW || (window & 1)) {
+        return false;
+    }
+
+    for(uint16_t i = 0; i < window; i++) {
+        history[i] = 0;
+    }
+
+    f->history = history;
+    f->window = window;
+    f->index = 0;
+    f->sum = 0;
+    f->reciprocal = ((1U << FILTER_RECIPROCAL_BITS) + window / 2) / window;
+
+    return true;
+}
+
+// Rounded sum / window, through the reciprocal
+static inline uint16_t filterAverage(const MovingAverage *f, uint32_t sum) {
+    return (uint16_t)((sum * f->reciprocal + (1U << (FILTER_RECIPROCAL_BITS - 1))) >> FILTER_RECIPROCAL_BITS);
+}
+
+void filterMovingAverage(MovingAverage *f, const uint16_t *in, uint16_t *out, uint16_t length) {
+    const FilterPair *inPairs = (const FilterPair *)in;
+    FilterPair *outPairs = (FilterPair *)out;
+    FilterPair *history = (FilterPair *)f->history;
+    uint16_t slot = f->index / 2;
+    uint16_t slots = f->window / 2;
+    uint32_t sum = f->sum;
+
+    for(uint16_t i = 0; i < length / 2; i++) {
+        uint32_t pair = inPairs[i];
+
+        // Both new minus oldest differences in one instruction
+        uint32_t diff = filterSsub16(pair, history[slot]);
+        history[slot] = pair;
+        if(++slot == slots) {
+            slot = 0;
+        }
+
+        sum += (int16_t)diff;
+        uint16_t first = filterAverage(f, sum);
+        sum += (int16_t)(diff >> 16);
+        uint16_t second = filterAverage(f, sum);
+
+        outPairs[i] = first | ((uint32_t)second << 16);
+    }
+
+    f->index = slot * 2;
+    f->sum = sum;
+}
+
+void filterIirInit(IirFilter *f, int16_t alpha, uint16_t initial) {
+    if(alpha < 1) {
+        alpha = 1;
+    }
+
+    f->alpha = alpha;
+    f->acc = (int32_t)initial << FILTER_IIR_FRACTION_BITS;
+}
+
+// The state rounded to a whole sample
+static inline uint16_t filterIirOutput(int32_t acc) {
+    return (uint16_t)((acc + (1 << (FILTER_IIR_FRACTION_BITS - 1))) >> FILTER_IIR_FRACTION_BITS);
+}
+
+// One filter step, acc += alpha * x - alpha * y in a single SMLAD. The
+// difference is taken from the rounded output, so a constant input is
+// reached exactly however small alpha is.
+static inline int32_t filterIirStep(uint32_t weights, int32_t acc, uint32_t x) {
+    uint32_t operands = x | ((uint32_t)filterIirOutput(acc) << 16);
+    return filterSmlad(operands, weights, acc);
+}
+
+void filterIir(IirFilter *f, const uint16_t *in, uint16_t *out, uint16_t length) {
+    const FilterPair *inPairs = (const FilterPair *)in;
+    FilterPair *outPairs = (FilterPair *)out;
+    uint32_t weights = (uint16_t)f->alpha | ((uint32_t)(uint16_t)-f->alpha << 16);
+    int32_t acc = f->acc;
+
+    for(uint16_t i = 0; i < length / 2; i++) {
+        uint32_t pair = inPairs[i];
+
+        acc = filterIirStep(weights, acc, pair & 0xFFFF);
+        uint16_t first = filterIirOutput(acc);
+        acc = filterIirStep(weights, acc, pair >> 16);
+        uint16_t second = filterIirOutput(acc);
+
+        outPairs[i] = first | ((uint32_t)second << 16);
+    }
+
+    f->acc = acc;
+}
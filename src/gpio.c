@@ -1,6 +1,7 @@
 
 #include "armory/gpio.h"
 #include "armory/rcc.h"
+#include "armory/bitband.h"
 
 
 void gpioInit(GPIO_TypeDef *gpio) {
@@ -11,15 +12,15 @@ void gpioInit(GPIO_TypeDef *gpio) {
 
     // Enable the GPIO clock for the port.
     if(gpio == GPIOA) {
-        RCC->AHB1ENR |= (1<<0);
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_GPIOAEN));
     } else if(gpio == GPIOB) {
-        RCC->AHB1ENR |= (1<<1);
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_GPIOBEN));
     } else if(gpio == GPIOC) {
-        RCC->AHB1ENR |= (1<<2);
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_GPIOCEN));
     } else if(gpio == GPIOD) {
-        RCC->AHB1ENR |= (1<<3);
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_GPIODEN));
     } else if(gpio == GPIOH) {
-        RCC->AHB1ENR |= (1<<7);
+        bitbandSet(&RCC->AHB1ENR, BITBAND_BIT(RCC_AHB1ENR_GPIOHEN));
     }
 }
 
@@ -62,10 +63,79 @@ void gpioSetPull(Pin pin, PinPullMode pullMode) {
 }
 
 void gpioSetOutputType(Pin pin, OutputType otype) {
-    // Clear bits in GPIOx_OTYPER at pin index
-    pin.port->OTYPER &= ~(1 << pin.pin);
-    // Set bits to desired output type
-    pin.port->OTYPER |= (otype << pin.pin);
+    // One bit per pin in GPIOx_OTYPER
+    bitbandWrite(&pin.port->OTYPER, pin.pin, otype);
+}
+
+void gpioSetOutputSpeed(Pin pin, OutputSpeed speed) {
+    // Clear bits in GPIOx_OSPEEDR at pin index
+    pin.port->OSPEEDR &= ~(0b11 << (pin.pin * 2));
+    // Set bits to desired output speed
+    pin.port->OSPEEDR |= (speed << (pin.pin * 2));
+}
+
+void gpioConfigure(const PinConfig cfg[], uint8_t n) {
+    for(int i = 0; i < n; i++) {
+        GPIO_TypeDef *port = cfg[i].pin.port;
+
+        // Each port is handled at its first entry, skip it afterwards
+        bool done = false;
+        for(int j = 0; j < i; j++) {
+            if(cfg[j].pin.port == port) {
+                done = true;
+                break;
+            }
+        }
+        if(done) {
+            continue;
+        }
+
+        // Bits to clear and new values of every register, for all pins of the port
+        uint32_t moderMask = 0, moder = 0;
+        uint32_t otyperMask = 0, otyper = 0;
+        uint32_t ospeedrMask = 0, ospeedr = 0;
+        uint32_t pupdrMask = 0, pupdr = 0;
+        uint32_t afrMask[2] = { 0, 0 }, afr[2] = { 0, 0 };
+
+        for(int j = i; j < n; j++) {
+            if(cfg[j].pin.port != port) {
+                continue;
+            }
+
+            uint8_t pin = cfg[j].pin.pin;
+
+            moderMask |= 0b11U << (pin * 2);
+            moder |= (uint32_t)cfg[j].mode << (pin * 2);
+
+            otyperMask |= 1U << pin;
+            otyper |= (uint32_t)cfg[j].otype << pin;
+
+            ospeedrMask |= 0b11U << (pin * 2);
+            ospeedr |= (uint32_t)cfg[j].speed << (pin * 2);
+
+            pupdrMask |= 0b11U << (pin * 2);
+            pupdr |= (uint32_t)cfg[j].pull << (pin * 2);
+
+            if(cfg[j].mode == ALTERNATE_FUNC) {
+                afrMask[pin / 8] |= 0xFU << ((pin % 8) * 4);
+                afr[pin / 8] |= (uint32_t)cfg[j].af << ((pin % 8) * 4);
+            }
+        }
+
+        gpioInit(port);
+
+        // One write per register, MODER last
+        if(afrMask[0]) {
+            port->AFR[0] = (port->AFR[0] & ~afrMask[0]) | afr[0];
+        }
+        if(afrMask[1]) {
+            port->AFR[1] = (port->AFR[1] & ~afrMask[1]) | afr[1];
+        }
+        port->OTYPER = (port->OTYPER & ~otyperMask) | otyper;
+        port->OSPEEDR = (port->OSPEEDR & ~ospeedrMask) | ospeedr;
+        port->PUPDR = (port->PUPDR & ~pupdrMask) | pupdr;
+        port->MODER = (port->MODER & ~moderMask) | moder;
+    }
 }
 
 PinState gpioDigitalRead(Pin pin) {
@@ -77,4 +147,74 @@ PinState gpioDigitalRead(Pin pin) {
     return LOW;
 }
 
+void gpioWritePort(GPIO_TypeDef *port, uint16_t setMask, uint16_t clearMask) {
+    // Set bits take priority over reset bits in BSRR
+    port->BSRR = setMask | ((uint32_t)clearMask << 16);
+}
+
+uint16_t gpioReadPort(GPIO_TypeDef *port, uint16_t mask) {
+    return port->IDR & mask;
+}
+
+bool gpioGroupInit(PinGroup *group, const Pin pins[], uint8_t count) {
+    if(count == 0 || count > 16) {
+        return false;
+    }
+
+    group->port = pins[0].port;
+    group->mask = 0;
+    group->count = count;
+    group->shift = pins[0].pin;
+    group->contiguous = true;
+
+    for(int i = 0; i < count; i++) {
+        if(pins[i].port != group->port || (group->mask & PIN_MASK(pins[i].pin))) {
+            return false;
+        }
+
+        group->pins[i] = pins[i].pin;
+        group->mask |= PIN_MASK(pins[i].pin);
+
+        if(pins[i].pin != group->shift + i) {
+            group->contiguous = false;
+        }
+    }
+
+    return true;
+}
+
+void gpioGroupWrite(const PinGroup *group, uint16_t value) {
+    uint32_t set;
+
+    if(group->contiguous) {
+        // The group value lines up with the port bits after one shift
+        set = ((uint32_t)value << group->shift) & group->mask;
+    } else {
+        set = 0;
+        for(int i = 0; i < group->count; i++) {
+            if(value & (1U << i)) {
+                set |= PIN_MASK(group->pins[i]);
+            }
+        }
+    }
+
+    // Everything in the group that is not set gets reset, in the same write
+    group->port->BSRR = set | ((group->mask & ~set) << 16);
+}
+
+uint16_t gpioGroupRead(const PinGroup *group) {
+    uint32_t idr = group->port->IDR;
 
+    if(group->contiguous) {
+        return (idr & group->mask) >> group->shift;
+    }
+
+    uint16_t value = 0;
+    for(int i = 0; i < group->count; i++) {
+        if(idr & PIN_MASK(group->pins[i])) {
+            value |= 1U << i;
+        }
+    }
+
+    return value;
+}
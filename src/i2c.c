@@ -2,28 +2,216 @@
 #include "armory/i2c.h"
 #include "armory/gpio.h"
 #include "armory/rcc.h"
+#include "armory/nvic.h"
+#include "armory/dma.h"
+#include "armory/timing.h"
+#include "armory/bitband.h"
+
+const I2CPinOption i2cSclPins[] = {
+    { I2C1, B6,  AF4 },
+    { I2C1, B8,  AF4 },
+    { I2C2, B10, AF4 },
+    { I2C3, A8,  AF4 },
+};
+
+const I2CPinOption i2cSdaPins[] = {
+    { I2C1, B7,  AF4 },
+    { I2C1, B9,  AF4 },
+    { I2C2, B11, AF4 },
+    { I2C2, B3,  AF9 },
+    { I2C2, B9,  AF9 },
+    { I2C3, C9,  AF4 },
+    { I2C3, B4,  AF9 },
+    { I2C3, B8,  AF9 },
+};
+
+// Queue, pins, interrupt lines and DMA1 requests of each I2C controller
+typedef struct {
+    I2C_TypeDef *instance;
+    IRQn evIrq;
+    IRQn erIrq;
+
+    // DMA1 stream/channel pairs wired to the controller's RX and TX requests
+    uint8_t rxStream;
+    uint8_t rxChannel;
+    uint8_t txStream;
+    uint8_t txChannel;
+
+    // Pins selected with i2cSetPins
+    I2CMap map;
+
+    bool dmaEnabled;
+    // Set while the current message is moved by DMA
+    bool dmaActive;
+    // Set once the current message's address has been ACKed
+    bool addressed;
+
+    // Nominal SCL frequency, used to size transaction deadlines
+    uint32_t sclFreq;
+    // The running transaction is aborted once this passes
+    Deadline deadline;
+    // Set while a timed out transaction's bus is being recovered
+    bool recovering;
+
+#if I2C_STATS_ENABLED
+    I2CStats stats;
+#endif
+
+    // Running transaction is at the head of the queue
+    I2CTransaction *head;
+    I2CTransaction *tail;
+
+    // Set while the bus is in target mode
+    I2CTarget *target;
+} I2CBus;
+
+static I2CBus i2cBuses[] = {
+    { I2C1, I2C1_EV_IRQn, I2C1_ER_IRQn, 0, 1, 6, 1, { I2C1, B6,  AF4, B7,  AF4 } },
+    { I2C2, I2C2_EV_IRQn, I2C2_ER_IRQn, 2, 7, 7, 7, { I2C2, B10, AF4, B11, AF4 } },
+    { I2C3, I2C3_EV_IRQn, I2C3_ER_IRQn, 1, 1, 4, 3, { I2C3, A8,  AF4, B4,  AF9 } }
+};
+
+#define I2C_CR2_IT_ALL (I2C_CR2_ITERREN | I2C_CR2_ITEVTEN | I2C_CR2_ITBUFEN)
+
+static I2CBus *getI2CBus(I2C_TypeDef *i2c) {
+    for(int i = 0; i < sizeof(i2cBuses) / sizeof(I2CBus); i++) {
+        if(i2c == i2cBuses[i].instance) {
+            return &i2cBuses[i];
+        }
+    }
+
+    return NULL;
+}
 
 const I2CMap *getI2CMap(I2C_TypeDef *i2c) {
-    for(int i = 0; i < sizeof(i2cPinMap) / sizeof(I2CMap); i++) {
-        if(i2c == i2cPinMap[i].instance) {
-            return &i2cPinMap[i];
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL) {
+        return NULL;
+    }
+
+    return &bus->map;
+}
+
+// Looks a pin up in an option table, returning NULL if it is not listed
+static const I2CPinOption *i2cFindPin(const I2CPinOption *options, int count,
+        I2C_TypeDef *i2c, Pin pin) {
+    for(int i = 0; i < count; i++) {
+        if(options[i].instance == i2c && options[i].pin.port == pin.port
+                && options[i].pin.pin == pin.pin) {
+            return &options[i];
         }
     }
 
     return NULL;
 }
 
+I2CResult i2cSetPins(I2C_TypeDef *i2c, Pin scl, Pin sda) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL) {
+        return I2C_ERROR;
+    }
+
+    const I2CPinOption *sclOption = i2cFindPin(i2cSclPins,
+            sizeof(i2cSclPins) / sizeof(I2CPinOption), i2c, scl);
+    const I2CPinOption *sdaOption = i2cFindPin(i2cSdaPins,
+            sizeof(i2cSdaPins) / sizeof(I2CPinOption), i2c, sda);
+    if(sclOption == NULL || sdaOption == NULL) {
+        return I2C_ERROR;
+    }
+
+    bus->map.sclPin = sclOption->pin;
+    bus->map.sclAf = sclOption->af;
+    bus->map.sdaPin = sdaOption->pin;
+    bus->map.sdaAf = sdaOption->af;
+
+    return I2C_OK;
+}
+
+// Waits until the flags in mask are all set (or all clear) in a register
+static I2CResult i2cWaitFlags(volatile uint32_t *reg, uint32_t mask, bool set) {
+    Deadline deadline = timingDeadline(I2C_TIMEOUT_US);
+
+    while(((*reg & mask) == mask) != set) {
+        if(timingExpired(&deadline)) {
+            return I2C_TIMEOUT;
+        }
+    }
+
+    return I2C_OK;
+}
+
+// Computes the CR2, CCR and TRISE values for a target SCL frequency
+static I2CResult i2cComputeTiming(uint32_t pclk1, uint32_t sclFreq, I2CDutyCycle duty,
+        uint32_t *cr2, uint32_t *ccr, uint32_t *trise) {
+    uint32_t freqMhz = pclk1 / 1000000;
+
+    if(sclFreq == 0 || sclFreq > I2C_SPEED_FAST || freqMhz > 50) {
+        return I2C_ERROR;
+    }
+
+    if(sclFreq <= I2C_SPEED_STANDARD) {
+        // Standard mode: Thigh = Tlow = CCR * Tpclk1, needs PCLK1 >= 2 MHz
+        if(freqMhz < 2) {
+            return I2C_ERROR;
+        }
+
+        uint32_t div = (pclk1 + 2 * sclFreq - 1) / (2 * sclFreq);
+        if(div < 4) {
+            div = 4;
+        } else if(div > I2C_CCR_CCR) {
+            return I2C_ERROR;
+        }
+
+        *ccr = div;
+        // 1000 ns maximum rise time
+        *trise = freqMhz + 1;
+    } else {
+        // Fast mode: Thigh + Tlow = 3 or 25 * CCR * Tpclk1, needs PCLK1 >= 4 MHz
+        if(freqMhz < 4) {
+            return I2C_ERROR;
+        }
+
+        uint32_t periods = (duty == I2C_DUTY_16_9) ? 25 : 3;
+        uint32_t div = (pclk1 + periods * sclFreq - 1) / (periods * sclFreq);
+        if(div < 1) {
+            div = 1;
+        } else if(div > I2C_CCR_CCR) {
+            return I2C_ERROR;
+        }
+
+        *ccr = I2C_CCR_FS | div;
+        if(duty == I2C_DUTY_16_9) {
+            *ccr |= I2C_CCR_DUTY;
+        }
+        // 300 ns maximum rise time
+        *trise = (freqMhz * 300) / 1000 + 1;
+    }
+
+    *cr2 = freqMhz;
+    return I2C_OK;
+}
+
 void i2cInit(I2C_TypeDef *i2c) {
+    i2cInitSpeed(i2c, I2C_SPEED_FAST, I2C_DUTY_2);
+}
+
+I2CResult i2cInitSpeed(I2C_TypeDef *i2c, uint32_t sclFreq, I2CDutyCycle duty) {
+    // Work out the bus timing before touching the peripheral
+    uint32_t cr2, ccr, trise;
+    if(i2cComputeTiming(rccGetPclk1Freq(), sclFreq, duty, &cr2, &ccr, &trise) != I2C_OK) {
+        return I2C_ERROR;
+    }
+
     // Enalbe given I2C in RCC
     if(i2c == I2C1) {
-        RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_I2C1EN));
     } else if(i2c == I2C2) {
-        RCC->APB1ENR |= RCC_APB1ENR_I2C2EN;
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_I2C2EN));
     } else if(i2c == I2C3) {
-        RCC->APB1ENR |= RCC_APB1ENR_I2C3EN;
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_I2C3EN));
     } else {
         // Return if invalid i2c
-        return;
+        return I2C_ERROR;
     }
 
     const I2CMap *map = getI2CMap(i2c);
@@ -44,28 +232,132 @@ void i2cInit(I2C_TypeDef *i2c) {
     i2c->CR1 = I2C_CR1_SWRST;
     i2c->CR1 = 0;
 
-    // Set i2c clock for fast mode
-    i2c->CR2 = 42;          // PCLK1 = 42 MHz
-    i2c->CCR = (1 << 15) | (0 << 14) | 30;  // FAST=1, DUTY=1, CCR=52 -> 400kHz
-    i2c->TRISE = 30;
-    
+    // Set i2c clock, must be done while the peripheral is disabled
+    i2c->CR2 = cr2;
+    i2c->CCR = ccr;
+    i2c->TRISE = trise;
 
     // Enable i2c peripheral
-    i2c->CR1 |= I2C_CR1_PE;
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+
+    // Drop anything queued before the reset and enable the bus interrupts.
+    // The peripheral only raises them while a transaction is running.
+    I2CBus *bus = getI2CBus(i2c);
+    bus->head = NULL;
+    bus->tail = NULL;
+    bus->target = NULL;
+    bus->sclFreq = i2cGetSpeed(i2c);
+    nvicEnableIrq(bus->evIrq);
+    nvicEnableIrq(bus->erIrq);
+
+    return I2C_OK;
 }
 
-void i2cStart(I2C_TypeDef *i2c) {
+uint32_t i2cGetSpeed(I2C_TypeDef *i2c) {
+    uint32_t ccr = i2c->CCR;
+    uint32_t div = ccr & I2C_CCR_CCR;
+
+    if(div == 0) {
+        return 0;
+    }
+
+    // Number of PCLK1 periods per SCL period
+    if(!(ccr & I2C_CCR_FS)) {
+        div *= 2;
+    } else if(ccr & I2C_CCR_DUTY) {
+        div *= 25;
+    } else {
+        div *= 3;
+    }
+
+    return rccGetPclk1Freq() / div;
+}
+
+// Drives SCL and SDA from GPIO to free a target stuck mid-byte. Returns true
+// if both lines are released afterwards.
+static bool i2cClearBus(const I2CMap *map) {
+    // Both pins are already open drain, so driving HIGH just releases them
+    gpioWrite(map->sclPin, HIGH);
+    gpioWrite(map->sdaPin, HIGH);
+    gpioPinMode(map->sclPin, OUTPUT);
+    gpioPinMode(map->sdaPin, OUTPUT);
+    delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+
+    // A target holding SDA low is waiting to send the rest of a byte,
+    // clock it out until it lets go
+    for(int i = 0; i < I2C_RECOVERY_CLOCKS && gpioDigitalRead(map->sdaPin) == LOW; i++) {
+        gpioWrite(map->sclPin, LOW);
+        delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+        gpioWrite(map->sclPin, HIGH);
+        delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    }
+
+    // Finish with a STOP, SDA rising while SCL is high
+    gpioWrite(map->sclPin, LOW);
+    delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpioWrite(map->sdaPin, LOW);
+    delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpioWrite(map->sclPin, HIGH);
+    delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+    gpioWrite(map->sdaPin, HIGH);
+    delay_us(I2C_RECOVERY_HALF_PERIOD_US);
+
+    bool released = gpioDigitalRead(map->sclPin) == HIGH && gpioDigitalRead(map->sdaPin) == HIGH;
+
+    // Hand the pins back to the peripheral
+    gpioPinMode(map->sclPin, ALTERNATE_FUNC);
+    gpioPinMode(map->sdaPin, ALTERNATE_FUNC);
+
+    return released;
+}
+
+// Frees the bus and resets the peripheral, keeping its timing and queue
+static I2CResult i2cResetBus(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+    const I2CMap *map = getI2CMap(i2c);
+
+    // The timing registers are cleared by the reset
+    uint32_t cr2 = i2c->CR2 & I2C_CR2_FREQ;
+    uint32_t ccr = i2c->CCR;
+    uint32_t trise = i2c->TRISE;
+
+    // Disabling the peripheral releases its hold on the lines
+    bitbandClear(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+    bool released = (map != NULL) && i2cClearBus(map);
+
+    // Reset clears a stuck BUSY flag and any half finished transfer
+    i2c->CR1 = I2C_CR1_SWRST;
+    i2c->CR1 = 0;
+
+    i2c->CR2 = cr2;
+    i2c->CCR = ccr;
+    i2c->TRISE = trise;
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+
+    return released ? I2C_OK : I2C_ERROR;
+}
+
+I2CResult i2cRecoverBus(I2C_TypeDef *i2c) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL) {
+        return I2C_ERROR;
+    }
+
+    return i2cResetBus(bus);
+}
+
+I2CResult i2cStart(I2C_TypeDef *i2c) {
     // Set the start bit in the control register
-    i2c->CR1 |= I2C_CR1_START;
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_START));
     // Wait for the start bit to be set in the status register
-    while(!(i2c->SR1 & I2C_SR1_SB));
+    return i2cWaitFlags(&i2c->SR1, I2C_SR1_SB, true);
 }
 
-void i2cStop(I2C_TypeDef *i2c) {
+I2CResult i2cStop(I2C_TypeDef *i2c) {
     // Set the stop bit in the control register
-    i2c->CR1 |= I2C_CR1_STOP;
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_STOP));
     // Wait until the busy bit is cleared in the status register
-    while(i2c->SR2 & I2C_SR2_BUSY);
+    return i2cWaitFlags(&i2c->SR2, I2C_SR2_BUSY, false);
 }
 
 I2CResult i2cSendAddr(I2C_TypeDef *i2c, uint8_t addr, bool read) {
@@ -75,22 +367,23 @@ I2CResult i2cSendAddr(I2C_TypeDef *i2c, uint8_t addr, bool read) {
     // Write the full address to the i2c data register
     i2c->DR = fullAddr;
 
-    // Wait for the address to be sent, checking timeout
-    uint16_t timeout = I2C_TIMEOUT_TIME;
-    while (!(i2c->SR1 & I2C_SR1_ADDR) && timeout--);
-    if (!timeout) {
-        return I2C_TIMEOUT;
-    }    
-
-    // Clear the ADDR flag by reading the status register
-    (void)i2c->SR2;
+    // Wait for the address to be ACKed or NACKed, checking timeout
+    Deadline deadline = timingDeadline(I2C_TIMEOUT_US);
+    while (!(i2c->SR1 & (I2C_SR1_ADDR | I2C_SR1_AF))) {
+        if(timingExpired(&deadline)) {
+            return I2C_TIMEOUT;
+        }
+    }
 
     // Check for NACK
     if (i2c->SR1 & I2C_SR1_AF) {
-        i2c->SR1 &= ~I2C_SR1_AF;
+        i2c->SR1 = ~I2C_SR1_AF;
         return I2C_NACK;
     }
 
+    // Clear the ADDR flag by reading the status register
+    (void)i2c->SR2;
+
     return I2C_OK;
 }
 
@@ -98,239 +391,892 @@ I2CResult i2cSendData(I2C_TypeDef *i2c, uint8_t data) {
     // Write the data to the i2c data register
     i2c->DR = data;
 
-    // Wait for the data to be sent, checking timeout
-    uint16_t timeout = I2C_TIMEOUT_TIME;
-    while (!(i2c->SR1 & I2C_SR1_BTF) && timeout--);
-    if(!timeout) {
-        return I2C_TIMEOUT;
+    // Wait for the data to be sent or NACKed, checking timeout
+    Deadline deadline = timingDeadline(I2C_TIMEOUT_US);
+    while (!(i2c->SR1 & (I2C_SR1_BTF | I2C_SR1_AF))) {
+        if(timingExpired(&deadline)) {
+            return I2C_TIMEOUT;
+        }
     }
 
     // Check for NACK
     if (i2c->SR1 & I2C_SR1_AF) {
-        i2c->SR1 &= ~I2C_SR1_AF;
+        i2c->SR1 = ~I2C_SR1_AF;
         return I2C_NACK;
     }
 
     return I2C_OK;
 }
 
-I2CResult i2cWriteByte(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t regAddr, uint8_t data) {
-    // Start the i2c connection
-    i2cStart(i2c);
-    
-    // Send device address to be targeted
-    I2CResult res = i2cSendAddr(i2c, devAddr, 0);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+static I2CMessage *i2cCurrentMessage(I2CBus *bus) {
+    return &bus->head->msgs[bus->head->msgIndex];
+}
+
+static bool i2cIsLastMessage(I2CBus *bus) {
+    return bus->head->msgIndex + 1 >= bus->head->count;
+}
+
+static void i2cStartDma(I2CBus *bus, I2CMessage *msg) {
+    bool read = msg->flags & I2C_MSG_READ;
+    uint8_t stream = read ? bus->rxStream : bus->txStream;
+    uint8_t channel = read ? bus->rxChannel : bus->txChannel;
+    DMA_Stream_TypeDef *s = dmaGetStream(DMA1, stream);
+
+    dmaDisableStream(DMA1, stream);
+    dmaClearFlags(DMA1, stream, DMA_FLAG_ALL);
+
+    s->PAR = (uint32_t)&bus->instance->DR;
+    s->M0AR = (uint32_t)msg->buf;
+    s->NDTR = msg->len;
+    s->FCR = 0; // Direct mode, bytes go straight to DR
+
+    // Reads finish on transfer complete, writes finish on the I2C BTF event
+    s->CR = (channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_TEIE;
+    if(read) {
+        s->CR |= DMA_SxCR_DIR_P2M | DMA_SxCR_TCIE;
+    } else {
+        s->CR |= DMA_SxCR_DIR_M2P;
     }
 
-    // Send register address of device
-    res = i2cSendData(i2c, regAddr);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    bitbandSet(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+}
+
+static void i2cStopDma(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+
+    i2c->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+
+    if(bus->dmaActive) {
+        bool read = i2cCurrentMessage(bus)->flags & I2C_MSG_READ;
+        dmaDisableStream(DMA1, read ? bus->rxStream : bus->txStream);
+        bus->dmaActive = false;
     }
+}
 
-    // Send data
-    res = i2cSendData(i2c, data);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+// Resets the per-message state, called before the message's (re)START
+static void i2cPrepareMessage(I2CBus *bus) {
+    I2CMessage *msg = i2cCurrentMessage(bus);
+
+    bus->head->index = 0;
+    bus->addressed = false;
+    bus->dmaActive = bus->dmaEnabled && msg->len >= I2C_DMA_MIN_LEN;
+
+    // Acknowledge received bytes until the end of a read
+    bitbandSet(&bus->instance->CR1, BITBAND_BIT(I2C_CR1_ACK));
+}
+
+static void i2cBeginTransaction(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+
+    bus->head->msgIndex = 0;
+    bus->deadline = timingDeadline(i2cGetTimeoutUs(i2c, bus->head));
+    i2cPrepareMessage(bus);
+
+    // A STOP from the previous transaction may still be going out. The
+    // controller holds the START until the bus is free (BUSY clear), and if
+    // it never is, the transaction deadline takes care of the bus.
+
+    // Hand the rest of the transaction over to the interrupt handlers.
+    // Buffer interrupts are only enabled once the address has been ACKed.
+    i2c->CR2 |= I2C_CR2_ITERREN | I2C_CR2_ITEVTEN;
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_START));
+}
+
+#if I2C_STATS_ENABLED
+static void i2cRecordStats(I2CBus *bus, const I2CTransaction *txn, I2CResult result) {
+    I2CStats *stats = &bus->stats;
+
+    // The deadline was started together with the transaction
+    uint32_t cycles = DWT_CYCCNT - bus->deadline.start;
+
+    // Count every byte of the messages that got through, and the part of
+    // the one that was running when a failure hit
+    bool reads = false;
+    bool writes = false;
+    for(int i = 0; i < txn->count; i++) {
+        if(txn->msgs[i].flags & I2C_MSG_READ) {
+            reads = true;
+        } else {
+            writes = true;
+        }
+
+        if(result == I2C_OK || i < txn->msgIndex) {
+            stats->bytes += txn->msgs[i].len;
+        } else if(i == txn->msgIndex) {
+            stats->bytes += txn->index;
+        }
     }
 
-    // Stop connection
-    i2cStop(i2c);
+    I2CStatType type = I2C_STAT_WRITE_READ;
+    if(!reads) {
+        type = I2C_STAT_WRITE;
+    } else if(!writes) {
+        type = I2C_STAT_READ;
+    }
 
-    return I2C_OK;
+    stats->transactions[type]++;
+    if(result == I2C_NACK) {
+        stats->nacks++;
+    } else if(result == I2C_TIMEOUT) {
+        stats->timeouts++;
+    } else if(result == I2C_ERROR) {
+        stats->errors++;
+    }
+
+    // Bucket by the position of the highest set bit, so each bucket spans
+    // twice the range of the one before
+    int bucket = 0;
+    if(cycles >> I2C_STATS_BUCKET_SHIFT) {
+        bucket = 32 - __builtin_clz(cycles >> I2C_STATS_BUCKET_SHIFT);
+    }
+    if(bucket >= I2C_STATS_BUCKETS) {
+        bucket = I2C_STATS_BUCKETS - 1;
+    }
+    stats->histogram[type][bucket]++;
+
+    if(cycles > stats->maxCycles[type]) {
+        stats->maxCycles[type] = cycles;
+    }
 }
+#endif
 
-I2CResult i2cWriteRaw(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t data) {
-    i2cStart(i2c);
- 
-    // Send device address to be targeted
-    I2CResult res = i2cSendAddr(i2c, devAddr, 0);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+static void i2cCompleteTransaction(I2CBus *bus, I2CResult result) {
+    I2C_TypeDef *i2c = bus->instance;
+    I2CTransaction *txn = bus->head;
+
+    // Silence the peripheral until there is more work
+    i2cStopDma(bus);
+    i2c->CR2 &= ~I2C_CR2_IT_ALL;
+
+#if I2C_STATS_ENABLED
+    i2cRecordStats(bus, txn, result);
+#endif
+
+    // Pop the finished transaction and start the next one, if any
+    bus->head = txn->next;
+    if(bus->head == NULL) {
+        bus->tail = NULL;
+    } else {
+        i2cBeginTransaction(bus);
     }
 
-    // Send data
-    res = i2cSendData(i2c, data);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    // Publish the result last, the callback is free to resubmit txn
+    txn->next = NULL;
+    txn->result = result;
+    if(txn->callback) {
+        txn->callback(txn);
     }
+}
 
-    i2cStop(i2c);
+// Requests what follows the current message, STOP after the last message
+// or a repeated START before the next one
+static void i2cRequestEnd(I2CBus *bus) {
+    if(i2cIsLastMessage(bus)) {
+        bitbandSet(&bus->instance->CR1, BITBAND_BIT(I2C_CR1_STOP));
+    } else {
+        bitbandSet(&bus->instance->CR1, BITBAND_BIT(I2C_CR1_START));
+    }
+}
 
-    return I2C_OK;
+// Moves on once the current message has been fully transferred
+static void i2cNextMessage(I2CBus *bus) {
+    i2cStopDma(bus);
+    bitbandClear(&bus->instance->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
+
+    if(i2cIsLastMessage(bus)) {
+        i2cCompleteTransaction(bus, I2C_OK);
+        return;
+    }
+
+    bus->head->msgIndex++;
+    i2cPrepareMessage(bus);
 }
 
-I2CResult i2cWriteBytes(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t *data, uint16_t n) {
-    if (!data || n == 0) {
-        return I2C_ERROR;
+// Points one of the bus DMA streams at a buffer for target mode. Neither
+// stream interrupts, the CPU only runs for the I2C events.
+static void i2cTargetArmStream(I2CBus *bus, bool read, uint8_t *buf, uint16_t len) {
+    uint8_t stream = read ? bus->rxStream : bus->txStream;
+    uint8_t channel = read ? bus->rxChannel : bus->txChannel;
+    DMA_Stream_TypeDef *s = dmaGetStream(DMA1, stream);
+
+    dmaDisableStream(DMA1, stream);
+    dmaClearFlags(DMA1, stream, DMA_FLAG_ALL);
+
+    s->PAR = (uint32_t)&bus->instance->DR;
+    s->M0AR = (uint32_t)buf;
+    s->NDTR = len;
+    s->FCR = 0;
+
+    s->CR = (channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC;
+    if(read) {
+        s->CR |= DMA_SxCR_DIR_P2M;
+    } else {
+        s->CR |= DMA_SxCR_DIR_M2P;
     }
 
-    i2cStart(i2c);
+    bitbandSet(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+}
 
-    // Send device address to be targeted
-    I2CResult res = i2cSendAddr(i2c, devAddr, 0);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+// Bytes of the current host write received so far, index included
+static uint16_t i2cTargetReceived(I2CBus *bus) {
+    return bus->target->size + 1 - dmaGetStream(DMA1, bus->rxStream)->NDTR;
+}
+
+// Takes the register index from the first byte of a write, past the end of
+// the map it wraps to 0
+static void i2cTargetSetIndex(I2CTarget *target) {
+    uint8_t index = target->staging[0];
+    target->reg = index < target->size ? index : 0;
+}
+
+// Gets both streams ready for the next transfer. A write lands in the
+// staging buffer in one go, index and data, a read starts at the current
+// index.
+static void i2cTargetArm(I2CBus *bus) {
+    I2CTarget *target = bus->target;
+
+    i2cTargetArmStream(bus, true, target->staging, target->size + 1);
+    i2cTargetArmStream(bus, false, &target->regs[target->reg], target->size - target->reg);
+
+    // Interrupt once on the first byte, to catch the index of a write
+    bitbandSet(&bus->instance->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
+}
+
+// Copies a host write from the staging buffer into the register map
+static void i2cTargetCommit(I2CBus *bus) {
+    I2CTarget *target = bus->target;
+    uint16_t received = i2cTargetReceived(bus);
+
+    target->count = 0;
+    if(received == 0) {
+        return;
+    }
+
+    // Data past the end of the map is dropped
+    i2cTargetSetIndex(target);
+    uint16_t count = received - 1;
+    if(count > target->size - target->reg) {
+        count = target->size - target->reg;
+    }
+
+    for(uint16_t i = 0; i < count; i++) {
+        target->regs[target->reg + i] = target->staging[1 + i];
+    }
+    target->count = count;
+}
+
+// Reports the end of a target transfer and re-arms for the next one
+static void i2cTargetEnd(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+    I2CTarget *target = bus->target;
+    uint16_t len = target->size - target->reg;
+
+    if(target->reading) {
+        // The TX stream refills DR as soon as a byte moves to the shift
+        // register, so one loaded byte was never sent
+        uint16_t loaded = len - dmaGetStream(DMA1, bus->txStream)->NDTR;
+        target->count = loaded > 0 ? loaded - 1 : 0;
+
+        // Toggling PE drops that byte, the next read starts at the index again.
+        // ACK is cleared along with PE.
+        bitbandClear(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+        bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+        bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_ACK));
+    } else {
+        i2cTargetCommit(bus);
+    }
+
+    // Re-arm first, the host may start again right after the callback
+    i2cTargetArm(bus);
+
+    if(target->callback) {
+        target->callback(target, I2C_TARGET_STOP);
+    }
+}
+
+// Handles the first byte of a transfer. For a write that is the register
+// index, and a read after a repeated START must start from it, so the TX
+// stream is pointed there before the host addresses us again.
+static void i2cTargetFirstByte(I2CBus *bus, uint32_t sr1) {
+    I2C_TypeDef *i2c = bus->instance;
+    I2CTarget *target = bus->target;
+
+    // The DMA is about to take a byte that just arrived
+    while(i2cTargetReceived(bus) == 0 && (i2c->SR1 & I2C_SR1_RXNE));
+
+    if(i2cTargetReceived(bus) > 0) {
+        bitbandClear(&i2c->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
+
+        // The TX stream only moves once a read has started, too late to
+        // serve it from the new index
+        if(dmaGetStream(DMA1, bus->txStream)->NDTR != target->size - target->reg) {
+            target->overruns++;
+        }
+
+        i2cTargetSetIndex(target);
+        i2cTargetArmStream(bus, false, &target->regs[target->reg], target->size - target->reg);
+    } else if(sr1 & I2C_SR1_TXE) {
+        // A read from the current index, the TX stream is already there
+        bitbandClear(&i2c->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
     }
+}
+
+/*
+ * Target mode, run from the I2Cx_EV interrupt. The DMA streams move all
+ * data, so only the first byte, ADDR and STOPF are handled here. With
+ * NOSTRETCH none of them holds the clock.
+ */
+static void i2cTargetEventHandler(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+    I2CTarget *target = bus->target;
+    uint32_t sr1 = i2c->SR1;
+
+    if(i2c->CR2 & I2C_CR2_ITBUFEN) {
+        i2cTargetFirstByte(bus, sr1);
+    }
+
+    if(sr1 & I2C_SR1_ADDR) {
+        // Reading SR2 after SR1 clears ADDR
+        uint32_t sr2 = i2c->SR2;
+
+        target->reading = sr2 & I2C_SR2_TRA;
+        target->matched = (sr2 & I2C_SR2_DUALF) ? target->addr2 : target->addr;
 
-    // For each byte in data array
-    for(int i = 0; i < n; i++) {
-        // Send data
-        res = i2cSendData(i2c, data[i]);
-        if(res != I2C_OK) {
-            i2cStop(i2c);
-            return res;
+        // A write before a repeated START gets no STOP of its own
+        if(target->reading && i2cTargetReceived(bus) > 0) {
+            i2cTargetCommit(bus);
+        }
+        target->count = 0;
+
+        if(target->callback) {
+            target->callback(target, I2C_TARGET_ADDRESS);
         }
     }
 
-    i2cStop(i2c);
+    if(sr1 & I2C_SR1_STOPF) {
+        // Writing CR1 after reading SR1 clears STOPF
+        bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+        i2cTargetEnd(bus);
+    }
+}
 
-    return I2C_OK;
+static void i2cTargetErrorHandler(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+    uint32_t sr1 = i2c->SR1;
+
+    i2c->SR1 = ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+
+    // A byte the DMA was not ready for, past the end of the staging buffer
+    // or the register map
+    if(sr1 & I2C_SR1_OVR) {
+        bus->target->overruns++;
+    }
+
+    if((sr1 & I2C_SR1_AF) && bus->target->reading) {
+        // The host NACKs the last byte it wants, no STOPF follows for reads
+        i2cTargetEnd(bus);
+    } else if(sr1 & I2C_SR1_BERR) {
+        // Misplaced START or STOP, drop the transfer
+        bus->target->reading = false;
+        i2cTargetArm(bus);
+    }
 }
 
-I2CResult i2cReadByte(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t regAddr, uint8_t *data) {
-    i2cStart(i2c);
+/*
+ * Master mode state machine, run from the I2Cx_EV interrupt.
+ *
+ * SB   -> send the address byte of the current message
+ * ADDR -> address was ACKed. Start the DMA stream or enable the buffer
+ *         interrupts, and set up ACK/STOP for single byte reads.
+ * TXE  -> load the next byte to send, BTF after the last one ends the write
+ * RXNE -> store a received byte. Once the second to last byte is read, the
+ *         last is already on the wire, so ACK is cleared and STOP (or the
+ *         repeated START of the next message) is requested then. This needs
+ *         the handler to run within one byte time (~22 us at 400 kHz).
+ *
+ * Between a write and the repeated START that follows it, BTF stays set
+ * until the START goes out. The addressed flag keeps those interrupts from
+ * touching the data register in the meantime.
+ */
+static void i2cEventHandler(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
+    I2CTransaction *txn = bus->head;
 
-    // Send device address
-    I2CResult res = i2cSendAddr(i2c, devAddr, 0);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    if(bus->target) {
+        i2cTargetEventHandler(bus);
+        return;
     }
 
-    // Send register address
-    res = i2cSendData(i2c, regAddr);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    uint32_t sr1 = i2c->SR1;
+
+    if(txn == NULL || bus->recovering) {
+        // Nothing running, nothing to handle
+        i2c->CR2 &= ~I2C_CR2_IT_ALL;
+        return;
     }
-    
-    // Restart by sending start and stop
-    i2cStop(i2c);
-    i2cStart(i2c);
 
-    // Re send device address with read signal
-    res = i2cSendAddr(i2c, devAddr, 1);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    I2CMessage *msg = i2cCurrentMessage(bus);
+    bool read = msg->flags & I2C_MSG_READ;
+
+    if(sr1 & I2C_SR1_SB) {
+        // Reading SR1 then writing DR clears SB
+        i2c->DR = (msg->addr << 1) | (read ? 1 : 0);
+        return;
     }
 
-    // Read data byte from data register
-    *data = (uint8_t)i2c->DR;
+    if(sr1 & I2C_SR1_ADDR) {
+        bus->addressed = true;
 
-    i2cStop(i2c);
-    return I2C_OK;
+        if(bus->dmaActive) {
+            // The stream starts serving requests as soon as ADDR is cleared.
+            // For reads LAST makes the controller NACK the final byte.
+            i2cStartDma(bus, msg);
+            bitbandSet(&i2c->CR2, BITBAND_BIT(I2C_CR2_DMAEN));
+            if(read) {
+                bitbandSet(&i2c->CR2, BITBAND_BIT(I2C_CR2_LAST));
+            }
+            (void)i2c->SR2;
+        } else if(read && msg->len == 1) {
+            // Single byte reads must NACK before ADDR is cleared
+            bitbandClear(&i2c->CR1, BITBAND_BIT(I2C_CR1_ACK));
+            (void)i2c->SR2;
+            i2cRequestEnd(bus);
+            bitbandSet(&i2c->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
+        } else if(!read && msg->len == 0) {
+            // Address-only write, used to probe for devices
+            (void)i2c->SR2;
+            i2cRequestEnd(bus);
+            i2cNextMessage(bus);
+        } else {
+            // Clear the ADDR flag by reading SR2
+            (void)i2c->SR2;
+            bitbandSet(&i2c->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
+        }
+        return;
+    }
+
+    if(!bus->addressed) {
+        return;
+    }
+
+    if(bus->dmaActive) {
+        // The DMA is moving the data. A write ends once the stream has
+        // emptied and the last byte has left the shift register.
+        DMA_Stream_TypeDef *s = dmaGetStream(DMA1, bus->txStream);
+        if(!read && (sr1 & I2C_SR1_BTF) && s->NDTR == 0) {
+            txn->index = msg->len;
+            i2cRequestEnd(bus);
+            i2cNextMessage(bus);
+        }
+        return;
+    }
+
+    if(read) {
+        if(sr1 & I2C_SR1_RXNE) {
+            msg->buf[txn->index++] = (uint8_t)i2c->DR;
+
+            if(msg->len - txn->index == 1) {
+                // NACK the final byte and end the message once it arrives
+                bitbandClear(&i2c->CR1, BITBAND_BIT(I2C_CR1_ACK));
+                i2cRequestEnd(bus);
+            } else if(txn->index == msg->len) {
+                i2cNextMessage(bus);
+            }
+        }
+    } else {
+        if((sr1 & I2C_SR1_TXE) && txn->index < msg->len) {
+            i2c->DR = msg->buf[txn->index++];
+
+            if(txn->index == msg->len) {
+                // Last byte loaded, only wake up again for BTF
+                bitbandClear(&i2c->CR2, BITBAND_BIT(I2C_CR2_ITBUFEN));
+            }
+        } else if((sr1 & I2C_SR1_BTF) && txn->index == msg->len) {
+            // Every byte has been shifted out and ACKed
+            i2cRequestEnd(bus);
+            i2cNextMessage(bus);
+        }
+    }
 }
 
-I2CResult i2cReadRaw(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t *data) {
-    i2cStart(i2c);
+static void i2cErrorHandler(I2CBus *bus) {
+    I2C_TypeDef *i2c = bus->instance;
 
-    // Send device address with read flag
-    I2CResult res = i2cSendAddr(i2c, devAddr, 1);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    if(bus->target) {
+        i2cTargetErrorHandler(bus);
+        return;
+    }
+
+    // The bus is being reset, the transaction is completed from there
+    if(bus->recovering) {
+        return;
+    }
+
+    uint32_t sr1 = i2c->SR1;
+
+    // Clear every error flag that was raised
+    i2c->SR1 = ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+
+    // After losing arbitration the controller is no longer the master
+    if(!(sr1 & I2C_SR1_ARLO)) {
+        bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_STOP));
     }
 
-    // Read data byte from i2c data register
-    *data = (uint8_t)i2c->DR;
+    if(bus->head == NULL) {
+        i2c->CR2 &= ~I2C_CR2_IT_ALL;
+        return;
+    }
+
+    if(sr1 & I2C_SR1_AF) {
+        i2cCompleteTransaction(bus, I2C_NACK);
+    } else {
+        i2cCompleteTransaction(bus, I2C_ERROR);
+    }
+}
+
+static void i2cDmaHandler(uint32_t flags, void *context) {
+    I2CBus *bus = (I2CBus *)context;
+
+    // Target mode streams run without interrupts
+    if(bus->target || bus->head == NULL || !bus->dmaActive) {
+        return;
+    }
+
+    I2CMessage *msg = i2cCurrentMessage(bus);
+
+    if(flags & DMA_FLAG_TE) {
+        bitbandSet(&bus->instance->CR1, BITBAND_BIT(I2C_CR1_STOP));
+        i2cCompleteTransaction(bus, I2C_ERROR);
+    } else if((msg->flags & I2C_MSG_READ) && (flags & DMA_FLAG_TC)) {
+        // Final byte was NACKed through LAST, STOP or START is set from here
+        bus->head->index = msg->len;
+        i2cRequestEnd(bus);
+        i2cNextMessage(bus);
+    }
+}
+
+// Aborts the running transaction once its deadline has passed, freeing the
+// bus so anything queued behind it can run
+static void i2cCheckDeadline(I2CBus *bus) {
+    uint32_t primask = nvicEnterCritical();
+
+    if(bus->head == NULL || bus->recovering || !timingExpired(&bus->deadline)) {
+        nvicExitCritical(primask);
+        return;
+    }
+
+    // Detach the bus from its interrupts. The transaction stays at the head,
+    // so anything submitted meanwhile only queues behind it.
+    i2cStopDma(bus);
+    bus->instance->CR2 &= ~I2C_CR2_IT_ALL;
+    bus->recovering = true;
+
+    nvicExitCritical(primask);
+
+    // The recovery takes up to I2C_RECOVERY_MAX_US, other interrupts keep
+    // running during it
+    i2cResetBus(bus);
+
+    primask = nvicEnterCritical();
+    bus->recovering = false;
+    i2cCompleteTransaction(bus, I2C_TIMEOUT);
+    nvicExitCritical(primask);
+}
+
+void I2C1_EV_IRQHandler(void) {
+    i2cEventHandler(&i2cBuses[0]);
+}
+
+void I2C1_ER_IRQHandler(void) {
+    i2cErrorHandler(&i2cBuses[0]);
+}
+
+void I2C2_EV_IRQHandler(void) {
+    i2cEventHandler(&i2cBuses[1]);
+}
+
+void I2C2_ER_IRQHandler(void) {
+    i2cErrorHandler(&i2cBuses[1]);
+}
+
+void I2C3_EV_IRQHandler(void) {
+    i2cEventHandler(&i2cBuses[2]);
+}
+
+void I2C3_ER_IRQHandler(void) {
+    i2cErrorHandler(&i2cBuses[2]);
+}
+
+void i2cEnableDma(I2C_TypeDef *i2c, bool enable) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL) {
+        return;
+    }
+
+    if(enable) {
+        dmaInit(DMA1);
+        dmaSetCallback(DMA1, bus->rxStream, i2cDmaHandler, bus);
+        dmaSetCallback(DMA1, bus->txStream, i2cDmaHandler, bus);
+    }
+
+    // Takes effect from the next message that starts
+    bus->dmaEnabled = enable;
+}
+
+I2CResult i2cTargetInit(I2C_TypeDef *i2c, I2CTarget *target) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL || target == NULL || target->regs == NULL || target->staging == NULL
+            || target->size == 0
+            || target->size > 256 || target->addr == 0 || target->addr > 0x7F
+            || target->addr2 > 0x7F) {
+        return I2C_ERROR;
+    }
+
+    // Pins, reset and CR2 FREQ are the same as for master mode. The SCL
+    // timing is unused, the host drives the clock.
+    if(i2cInitSpeed(i2c, I2C_SPEED_FAST, I2C_DUTY_2) != I2C_OK) {
+        return I2C_ERROR;
+    }
+
+    target->instance = i2c;
+    target->matched = target->addr;
+    target->reading = false;
+    target->reg = 0;
+    target->count = 0;
+    target->overruns = 0;
+
+    bitbandClear(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+    i2c->OAR1 = I2C_OAR1_RESERVED | (target->addr << I2C_OAR1_ADD_Pos);
+    if(target->addr2) {
+        i2c->OAR2 = I2C_OAR2_ENDUAL | (target->addr2 << I2C_OAR2_ADD2_Pos);
+    } else {
+        i2c->OAR2 = 0;
+    }
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_NOSTRETCH));
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_PE));
+    bitbandSet(&i2c->CR1, BITBAND_BIT(I2C_CR1_ACK));
+
+    dmaInit(DMA1);
+    dmaSetCallback(DMA1, bus->rxStream, i2cDmaHandler, bus);
+    dmaSetCallback(DMA1, bus->txStream, i2cDmaHandler, bus);
+
+    bus->target = target;
+    i2cTargetArm(bus);
+
+    // Every byte goes through DMA, the buffer interrupt is only enabled for
+    // the first one of a transfer
+    i2c->CR2 |= I2C_CR2_DMAEN | I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
 
-    i2cStop(i2c);
     return I2C_OK;
 }
 
-uint8_t i2cReceiveData(I2C_TypeDef *i2c, bool ack) {
-    // Set ACK/NACK bit
-    if(ack) {
-        i2c->CR1 |= I2C_CR1_ACK;
+I2CResult i2cSubmit(I2C_TypeDef *i2c, I2CTransaction *txn) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL || bus->target != NULL || txn == NULL || txn->msgs == NULL || txn->count == 0) {
+        return I2C_ERROR;
+    }
+
+    // Reads need at least one byte, writes may be address-only
+    for(int i = 0; i < txn->count; i++) {
+        const I2CMessage *msg = &txn->msgs[i];
+        if(msg->len > 0 && msg->buf == NULL) {
+            return I2C_ERROR;
+        }
+        if((msg->flags & I2C_MSG_READ) && msg->len == 0) {
+            return I2C_ERROR;
+        }
+    }
+
+    txn->instance = i2c;
+    txn->result = I2C_BUSY;
+    txn->msgIndex = 0;
+    txn->index = 0;
+    txn->next = NULL;
+
+    // The queue is shared with the interrupt handlers
+    uint32_t primask = nvicEnterCritical();
+
+    if(bus->tail) {
+        // Bus is busy, run after everything already queued
+        bus->tail->next = txn;
+        bus->tail = txn;
     } else {
-        i2c->CR1 &= ~I2C_CR1_ACK;
+        bus->head = txn;
+        bus->tail = txn;
+        i2cBeginTransaction(bus);
     }
 
-    // Wait until the data register is  not empty
-    while (!(i2c->SR1 & I2C_SR1_RXNE));
+    nvicExitCritical(primask);
 
-    // Return the data register
-    return (uint8_t) i2c->DR;
+    return I2C_OK;
 }
 
-I2CResult i2cReadBytes(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t regAddr, uint8_t *buffer, uint16_t len) {
-    i2cStart(i2c);
+I2CResult i2cWait(const I2CTransaction *txn) {
+    I2CBus *bus = getI2CBus(txn->instance);
 
-    // Send device address with write bit
-    I2CResult res = i2cSendAddr(i2c, devAddr, 0);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    while(txn->result == I2C_BUSY) {
+        i2cCheckDeadline(bus);
     }
 
-    // Send register address 
-    res = i2cSendData(i2c, regAddr);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    return txn->result;
+}
+
+void i2cPollTimeout(I2C_TypeDef *i2c) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus != NULL) {
+        i2cCheckDeadline(bus);
     }
+}
 
-    // Restart i2c connection
-    i2cStop(i2c);
-    i2cStart(i2c);
+I2CResult i2cWaitAll(I2CTransaction *const txns[], uint8_t count) {
+    bool busy = true;
 
-    // Send device address with read flag
-    res = i2cSendAddr(i2c, devAddr, 1);
-    if(res != I2C_OK) {
-        i2cStop(i2c);
-        return res;
+    while(busy) {
+        busy = false;
+        for(int i = 0; i < count; i++) {
+            if(txns[i]->result == I2C_BUSY) {
+                busy = true;
+            }
+        }
+
+        // Transactions on other buses keep running from their interrupts
+        i2cPollAll();
     }
 
-    // Receive bytes
-    for(uint16_t i = 0; i < len; i++) {
-        if(i == len-1) {
-            // Last byte, send NACK
-            buffer[i] = i2cReceiveData(i2c, false);
-        } else {
-            // Not last byte, send ACK
-            buffer[i] = i2cReceiveData(i2c, true);
+    for(int i = 0; i < count; i++) {
+        if(txns[i]->result != I2C_OK) {
+            return txns[i]->result;
         }
     }
 
-    // Stop the i2c connection
-    i2cStop(i2c);
+    return I2C_OK;
+}
+
+void i2cPollAll(void) {
+    for(int i = 0; i < sizeof(i2cBuses) / sizeof(I2CBus); i++) {
+        i2cCheckDeadline(&i2cBuses[i]);
+    }
+}
+
+uint32_t i2cGetTimeoutUs(I2C_TypeDef *i2c, const I2CTransaction *txn) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL || bus->sclFreq == 0) {
+        return I2C_TIMEOUT_US;
+    }
+
+    // Every message costs an address byte, every byte 9 clocks with its ACK
+    uint32_t bits = 0;
+    for(int i = 0; i < txn->count; i++) {
+        bits += (txn->msgs[i].len + 1) * 9;
+    }
+
+    // Nominal bus time plus slack for clock stretching
+    return I2C_TIMEOUT_US + (bits * 1000) / (bus->sclFreq / 1000);
+}
+
+#if I2C_STATS_ENABLED
+I2CResult i2cGetStats(I2C_TypeDef *i2c, I2CStats *stats) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL || stats == NULL) {
+        return I2C_ERROR;
+    }
+
+    // Copy in one go so the snapshot is consistent
+    uint32_t primask = nvicEnterCritical();
+    *stats = bus->stats;
+    nvicExitCritical(primask);
 
     return I2C_OK;
 }
 
-I2CResult i2cReadRawBytes(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t *buffer, uint16_t len) {
-    i2cStart(i2c);
+void i2cResetStats(I2C_TypeDef *i2c) {
+    I2CBus *bus = getI2CBus(i2c);
+    if(bus == NULL) {
+        return;
+    }
+
+    uint32_t primask = nvicEnterCritical();
+    bus->stats = (I2CStats){ 0 };
+    nvicExitCritical(primask);
+}
+#endif
+
+bool i2cIsIdle(I2C_TypeDef *i2c) {
+    I2CBus *bus = getI2CBus(i2c);
+    return bus == NULL || bus->head == NULL;
+}
+
+I2CResult i2cTransfer(I2C_TypeDef *i2c, I2CMessage *msgs, uint8_t n) {
+    I2CTransaction txn = {
+        .msgs = msgs,
+        .count = n
+    };
 
-    // Send the device address with the read flag
-    I2CResult res = i2cSendAddr(i2c, devAddr, 1);
+    I2CResult res = i2cSubmit(i2c, &txn);
     if(res != I2C_OK) {
-        i2cStop(i2c);
         return res;
     }
 
-    // Receive bytes
-    for(uint16_t i = 0; i < len; i++) {
-        if(i == len-1) {
-            // Last byte, send NACK
-            buffer[i] = i2cReceiveData(i2c, false);
-        } else {
-            // Not last byte, send ACK
-            buffer[i] = i2cReceiveData(i2c, true);
-        }
+    return i2cWait(&txn);
+}
+
+I2CResult i2cWriteByte(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t regAddr, uint8_t data) {
+    // Register address followed by the data byte
+    uint8_t buffer[2] = { regAddr, data };
+    I2CMessage msg = { devAddr, 0, sizeof(buffer), buffer };
+
+    return i2cTransfer(i2c, &msg, 1);
+}
+
+I2CResult i2cWriteRaw(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t data) {
+    I2CMessage msg = { devAddr, 0, 1, &data };
+    return i2cTransfer(i2c, &msg, 1);
+}
+
+I2CResult i2cWriteBytes(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t *data, uint16_t n) {
+    if (!data || n == 0) {
+        return I2C_ERROR;
     }
 
-    // Stop the i2c connection
-    i2cStop(i2c);
+    I2CMessage msg = { devAddr, 0, n, data };
+    return i2cTransfer(i2c, &msg, 1);
+}
+
+I2CResult i2cReadByte(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t regAddr, uint8_t *data) {
+    return i2cReadBytes(i2c, devAddr, regAddr, data, 1);
+}
 
+I2CResult i2cReadRaw(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t *data) {
+    I2CMessage msg = { devAddr, I2C_MSG_READ, 1, data };
+    return i2cTransfer(i2c, &msg, 1);
+}
+
+I2CResult i2cReceiveData(I2C_TypeDef *i2c, bool ack, uint8_t *data) {
+    // Set ACK/NACK bit
+    bitbandWrite(&i2c->CR1, BITBAND_BIT(I2C_CR1_ACK), ack);
+
+    // Wait until the data register is  not empty
+    I2CResult res = i2cWaitFlags(&i2c->SR1, I2C_SR1_RXNE, true);
+    if(res != I2C_OK) {
+        return res;
+    }
+
+    // Return the data register
+    *data = (uint8_t) i2c->DR;
     return I2C_OK;
 }
+
+I2CResult i2cReadBytes(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t regAddr, uint8_t *buffer, uint16_t len) {
+    // Register address write, then a repeated START into the read
+    I2CMessage msgs[2] = {
+        { devAddr, 0,            1,   &regAddr },
+        { devAddr, I2C_MSG_READ, len, buffer   }
+    };
+
+    return i2cTransfer(i2c, msgs, 2);
+}
+
+I2CResult i2cReadRawBytes(I2C_TypeDef *i2c, uint8_t devAddr, uint8_t *buffer, uint16_t len) {
+    I2CMessage msg = { devAddr, I2C_MSG_READ, len, buffer };
+    return i2cTransfer(i2c, &msg, 1);
+}
@@ -0,0 +1,33 @@
+#include "armory/nvic.h"
+
+void nvicEnableIrq(IRQn irq) {
+    // Each ISER register holds enable bits for 32 interrupts
+    NVIC_ISER[irq >> 5] = (1U << (irq & 0x1F));
+}
+
+void nvicDisableIrq(IRQn irq) {
+    NVIC_ICER[irq >> 5] = (1U << (irq & 0x1F));
+}
+
+void nvicClearPending(IRQn irq) {
+    NVIC_ICPR[irq >> 5] = (1U << (irq & 0x1F));
+}
+
+void nvicSetPriority(IRQn irq, uint8_t priority) {
+    // Only the upper bits of the priority byte are implemented
+    NVIC_IPR[irq] = (uint8_t)(priority << (8 - NVIC_PRIO_BITS));
+}
+
+uint32_t nvicEnterCritical(void) {
+    uint32_t primask;
+
+    // Save the current mask before disabling interrupts
+    __asm__ volatile ("mrs %0, primask" : "=r" (primask));
+    __asm__ volatile ("cpsid i" ::: "memory");
+
+    return primask;
+}
+
+void nvicExitCritical(uint32_t primask) {
+    __asm__ volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
@@ -3,6 +3,7 @@
 #include "armory/gpio.h"
 #include "armory/tim.h"
 #include "armory/rcc.h"
+#include "armory/bitband.h"
 
 // NOTE: Most pins can be mapped to multiple PWM channels. These were chosen 
 // arbitrarily and are not set in stone, however, they were chosen to utilize
@@ -40,16 +41,16 @@ const PwmChannelMap *getPwmMap(Pin pin) {
 void pwmInitTimer(TIM_TypeDef *timer, TimerChannel channel) {
     // Enable to timer clock
     if(timer == TIM1) {
-        RCC->APB2ENR |= (1 << 0);
+        bitbandSet(&RCC->APB2ENR, BITBAND_BIT(RCC_APB2ENR_TIM1EN));
     } else if(timer == TIM2) {
-        RCC->APB1ENR |= (1 << 0);
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM2EN));
     } else if(timer == TIM3) {
-        RCC->APB1ENR |= (1 << 1);
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM3EN));
     } else if(timer == TIM4) {
-        RCC->APB1ENR |= (1 << 2);
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM4EN));
     } else if(timer == TIM5) {
         // Current configuration does not use TIM5, but include for future proofing
-        RCC->APB1ENR |= (1<<3);
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM5EN));
     } else {
         // Invalid PWM pin
         return;
@@ -58,8 +59,8 @@ void pwmInitTimer(TIM_TypeDef *timer, TimerChannel channel) {
     // Setup timer registers
     timer->PSC = 327; // Roughly 1khz PWM frequency
     timer->ARR = 255; // Allow PWM values to be written to 8 bits
-    timer->CR1 |= (1 << 7); // ARPE
-    timer->CR1 |= (1 << 0); // CEN
+    bitbandSet(&timer->CR1, BITBAND_BIT(TIM_CR1_ARPE));
+    bitbandSet(&timer->CR1, BITBAND_BIT(TIM_CR1_CEN));
     //timer->CCMR1 |= (0x06 << 4); // Set OC1 mode to PWM
     //timer->CCMR1 |= (1 << 3); // Enable OC1 Preload
     //timer->CCER |= (1 << 0); //Enable capture/compare CH1 output
@@ -70,26 +71,26 @@ void pwmInitTimer(TIM_TypeDef *timer, TimerChannel channel) {
         case CH1:
             timer->CCMR1 &= ~(0b111 << 4);
             timer->CCMR1 |=  (0b110 << 4);
-            timer->CCMR1 |=  (1 << 3); // OC1PE
-            timer->CCER   |=  (1 << 0); // CC1E
+            bitbandSet(&timer->CCMR1, BITBAND_BIT(TIM_CCMR1_OC1PE));
+            bitbandSet(&timer->CCER, BITBAND_BIT(TIM_CCER_CC1E));
             break;
         case CH2:
             timer->CCMR1 &= ~(0b111 << 12);
             timer->CCMR1 |=  (0b110 << 12);
-            timer->CCMR1 |=  (1 << 11); // OC2PE
-            timer->CCER   |=  (1 << 4); // CC2E
+            bitbandSet(&timer->CCMR1, BITBAND_BIT(TIM_CCMR1_OC2PE));
+            bitbandSet(&timer->CCER, BITBAND_BIT(TIM_CCER_CC2E));
             break;
         case CH3:
             timer->CCMR2 &= ~(0b111 << 4);
             timer->CCMR2 |=  (0b110 << 4);
-            timer->CCMR2 |=  (1 << 3); // OC3PE
-            timer->CCER   |=  (1 << 8); // CC3E
+            bitbandSet(&timer->CCMR2, BITBAND_BIT(TIM_CCMR2_OC3PE));
+            bitbandSet(&timer->CCER, BITBAND_BIT(TIM_CCER_CC3E));
             break;
         case CH4:
             timer->CCMR2 &= ~(0b111 << 12);
             timer->CCMR2 |=  (0b110 << 12);
-            timer->CCMR2 |=  (1 << 11); // OC4PE
-            timer->CCER   |=  (1 << 12); // CC4E
+            bitbandSet(&timer->CCMR2, BITBAND_BIT(TIM_CCMR2_OC4PE));
+            bitbandSet(&timer->CCER, BITBAND_BIT(TIM_CCER_CC4E));
             break;
         case CH5:
             // Don't implement CH5 for now.
@@ -97,7 +98,7 @@ void pwmInitTimer(TIM_TypeDef *timer, TimerChannel channel) {
     }
 
     if(timer == TIM1) {
-        timer->BDTR |= (1 << 15);
+        bitbandSet(&timer->BDTR, BITBAND_BIT(TIM_BDTR_MOE));
     }
 }
 
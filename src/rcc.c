@@ -1,10 +1,11 @@
 
 #include "armory/rcc.h"
 #include "armory/flash.h"
+#include "armory/bitband.h"
 
 void rccInit(void) {
     // Enable HSE
-    RCC->CR |= RCC_CR_HSEON;
+    bitbandSet(&RCC->CR, BITBAND_BIT(RCC_CR_HSEON));
     while (!(RCC->CR & RCC_CR_HSERDY));
 
     // Configure the PLL: PLLCLK = (HSE / PLL_M) * PLL_N / PLL_P
@@ -24,10 +25,74 @@ void rccInit(void) {
     RCC->CFGR |= RCC_CFGR_PPRE2_DIV1;    // APB2 = /1 (84 MHz)
     
     // Enable the PLL
-    RCC->CR |= RCC_CR_PLLON;
+    bitbandSet(&RCC->CR, BITBAND_BIT(RCC_CR_PLLON));
     while (!(RCC->CR & RCC_CR_PLLRDY));
 
     // Switch system clock to PLL
     RCC->CFGR |= RCC_CFGR_SW_PLL;
     while ((RCC->CFGR & RCC_CFGR_SWS_MSK) != RCC_CFGR_SWS_PLL);
 }
+
+uint32_t rccGetSysclkFreq(void) {
+    uint32_t sws = RCC->CFGR & RCC_CFGR_SWS_MSK;
+
+    if(sws == RCC_CFGR_SWS_HSI) {
+        return RCC_HSI_FREQ;
+    } else if(sws == RCC_CFGR_SWS_HSE) {
+        return RCC_HSE_FREQ;
+    }
+
+    // PLLCLK = (PLL input / PLL_M) * PLL_N / PLL_P
+    uint32_t pllcfgr = RCC->PLLCFGR;
+    uint32_t input = (pllcfgr & RCC_PLLCFGR_PLLSRC_HSE) ? RCC_HSE_FREQ : RCC_HSI_FREQ;
+    uint32_t m = (pllcfgr >> RCC_PLLCFGR_PLLM_POS) & 0x3F;
+    uint32_t n = (pllcfgr >> RCC_PLLCFGR_PLLN_POS) & 0x1FF;
+    uint32_t p = (((pllcfgr >> RCC_PLLCFGR_PLLP_POS) & 0x03) + 1) * 2;
+
+    // Divide first to stay within 32 bits
+    return (input / m) * n / p;
+}
+
+uint32_t rccGetHclkFreq(void) {
+    uint32_t hpre = (RCC->CFGR >> RCC_CFGR_HPRE_Pos) & 0x0F;
+
+    // 0xxx: no division, 1000-1011: /2 to /16, 1100-1111: /64 to /512
+    if(hpre < 8) {
+        return rccGetSysclkFreq();
+    } else if(hpre < 12) {
+        return rccGetSysclkFreq() >> (hpre - 7);
+    }
+    return rccGetSysclkFreq() >> (hpre - 6);
+}
+
+// Applies an APB prescaler field (0xx: no division, 1xx: /2 to /16)
+static uint32_t rccApbFreq(uint32_t ppre) {
+    if(ppre < 4) {
+        return rccGetHclkFreq();
+    }
+    return rccGetHclkFreq() >> (ppre - 3);
+}
+
+uint32_t rccGetPclk1Freq(void) {
+    return rccApbFreq((RCC->CFGR >> RCC_CFGR_PPRE1_Pos) & 0x07);
+}
+
+uint32_t rccGetPclk2Freq(void) {
+    return rccApbFreq((RCC->CFGR >> RCC_CFGR_PPRE2_Pos) & 0x07);
+}
+
+// Timers get double the APB clock when its prescaler is anything but /1
+static uint32_t rccTimerFreq(uint32_t ppre, uint32_t pclk) {
+    if(ppre < 4) {
+        return pclk;
+    }
+    return pclk * 2;
+}
+
+uint32_t rccGetApb1TimerFreq(void) {
+    return rccTimerFreq((RCC->CFGR >> RCC_CFGR_PPRE1_Pos) & 0x07, rccGetPclk1Freq());
+}
+
+uint32_t rccGetApb2TimerFreq(void) {
+    return rccTimerFreq((RCC->CFGR >> RCC_CFGR_PPRE2_Pos) & 0x07, rccGetPclk2Freq());
+}
@@ -0,0 +1,198 @@
+#include "armory/regmap.h"
+
+// Cache index of a register, or -1 if the register is not cached
+static int regmapIndex(const Regmap *map, uint8_t reg) {
+    if(reg < map->base || reg - map->base >= map->count) {
+        return -1;
+    }
+
+    return reg - map->base;
+}
+
+I2CResult regmapInit(Regmap *map, I2C_TypeDef *i2c, uint8_t addr, uint8_t base,
+        uint16_t count, uint8_t *cache, uint8_t *state) {
+    if(map == NULL || cache == NULL || state == NULL || count == 0 || base + count > 256) {
+        return I2C_ERROR;
+    }
+
+    map->i2c = i2c;
+    map->addr = addr;
+    map->base = base;
+    map->count = count;
+    map->cache = cache;
+    map->state = state;
+
+    for(int i = 0; i < count; i++) {
+        map->cache[i] = 0;
+        map->state[i] = 0;
+    }
+
+    return I2C_OK;
+}
+
+void regmapSetVolatile(Regmap *map, uint8_t reg, bool isVolatile) {
+    int i = regmapIndex(map, reg);
+    if(i < 0) {
+        return;
+    }
+
+    // A pending write is still sent by the next flush, only the cached
+    // value stops counting
+    if(isVolatile) {
+        map->state[i] = (map->state[i] & REGMAP_DIRTY) | REGMAP_VOLATILE;
+    } else {
+        map->state[i] &= ~REGMAP_VOLATILE;
+    }
+}
+
+void regmapSeed(Regmap *map, uint8_t reg, uint8_t value) {
+    int i = regmapIndex(map, reg);
+    if(i < 0 || (map->state[i] & REGMAP_VOLATILE)) {
+        return;
+    }
+
+    map->cache[i] = value;
+    map->state[i] = REGMAP_VALID;
+}
+
+void regmapInvalidate(Regmap *map) {
+    for(int i = 0; i < map->count; i++) {
+        map->state[i] &= REGMAP_VOLATILE;
+    }
+}
+
+I2CResult regmapRefresh(Regmap *map) {
+    uint8_t buffer[REGMAP_MAX_BURST];
+    int start = 0;
+
+    while(start < map->count) {
+        // Reading a volatile register may clear flags or pop a FIFO, so the
+        // bursts only cover the runs in between
+        if(map->state[start] & REGMAP_VOLATILE) {
+            start++;
+            continue;
+        }
+
+        int len = 1;
+        while(start + len < map->count && len < REGMAP_MAX_BURST
+                && !(map->state[start + len] & REGMAP_VOLATILE)) {
+            len++;
+        }
+
+        I2CResult result = i2cReadBytes(map->i2c, map->addr, map->base + start, buffer, len);
+        if(result != I2C_OK) {
+            return result;
+        }
+
+        // Pending writes win over what the device holds now
+        for(int i = 0; i < len; i++) {
+            uint8_t *state = &map->state[start + i];
+            if(!(*state & REGMAP_DIRTY)) {
+                map->cache[start + i] = buffer[i];
+                *state |= REGMAP_VALID;
+            }
+        }
+
+        start += len;
+    }
+
+    return I2C_OK;
+}
+
+I2CResult regmapRead(Regmap *map, uint8_t reg, uint8_t *value) {
+    int i = regmapIndex(map, reg);
+
+    if(i >= 0 && (map->state[i] & (REGMAP_VALID | REGMAP_DIRTY))) {
+        *value = map->cache[i];
+        return I2C_OK;
+    }
+
+    I2CResult result = i2cReadByte(map->i2c, map->addr, reg, value);
+    if(result == I2C_OK && i >= 0 && !(map->state[i] & REGMAP_VOLATILE)) {
+        map->cache[i] = *value;
+        map->state[i] |= REGMAP_VALID;
+    }
+
+    return result;
+}
+
+I2CResult regmapWrite(Regmap *map, uint8_t reg, uint8_t value) {
+    int i = regmapIndex(map, reg);
+
+    if(i < 0 || (map->state[i] & REGMAP_VOLATILE)) {
+        return i2cWriteByte(map->i2c, map->addr, reg, value);
+    }
+
+    // Either the device already holds the value, or it is already pending
+    if((map->state[i] & (REGMAP_VALID | REGMAP_DIRTY)) && map->cache[i] == value) {
+        return I2C_OK;
+    }
+
+    map->cache[i] = value;
+    map->state[i] |= REGMAP_DIRTY;
+
+    return I2C_OK;
+}
+
+I2CResult regmapUpdateBits(Regmap *map, uint8_t reg, uint8_t mask, uint8_t value) {
+    uint8_t current;
+
+    I2CResult result = regmapRead(map, reg, &current);
+    if(result != I2C_OK) {
+        return result;
+    }
+
+    return regmapWrite(map, reg, (current & ~mask) | (value & mask));
+}
+
+I2CResult regmapFlush(Regmap *map) {
+    // Register address followed by the burst data
+    uint8_t buffer[1 + REGMAP_MAX_BURST];
+    I2CResult result = I2C_OK;
+    int i = 0;
+
+    while(i < map->count) {
+        if(!(map->state[i] & REGMAP_DIRTY)) {
+            i++;
+            continue;
+        }
+
+        // Grow the run while registers are dirty, or clean but known and
+        // close enough to the last dirty one that rewriting them is cheaper
+        // than starting a new burst
+        int start = i;
+        int end = i;
+        for(int j = i + 1; j < map->count && j - start < REGMAP_MAX_BURST; j++) {
+            uint8_t state = map->state[j];
+
+            if(state & REGMAP_DIRTY) {
+                end = j;
+            } else if(!(state & REGMAP_VALID) || (state & REGMAP_VOLATILE)
+                    || j - end > REGMAP_MERGE_GAP) {
+                break;
+            }
+        }
+
+        int len = end - start + 1;
+        buffer[0] = map->base + start;
+        for(int k = 0; k < len; k++) {
+            buffer[1 + k] = map->cache[start + k];
+        }
+
+        I2CResult burst = i2cWriteBytes(map->i2c, map->addr, buffer, 1 + len);
+        if(burst == I2C_OK) {
+            // Volatile registers are sent but never become valid
+            for(int k = start; k <= end; k++) {
+                uint8_t state = map->state[k] & ~REGMAP_DIRTY;
+                map->state[k] = (state & REGMAP_VOLATILE) ? state : state | REGMAP_VALID;
+            }
+        } else if(result == I2C_OK) {
+            // Keep going, so one bad burst does not hold back the others
+            result = burst;
+        }
+
+        i = end + 1;
+    }
+
+    return result;
+}
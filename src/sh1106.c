@@ -0,0 +1,530 @@
+
+#include "armory/sh1106.h"
+#include "armory/i2c.h"
+#include "armory/nvic.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Two frames, drawn into one while the other is sent. Every page starts with
+// the data control byte, so it can be handed to the DMA in place.
+static uint8_t frameBuffers[2][SH1106_PAGE_COUNT * SH1106_PAGE_STRIDE];
+static uint8_t *backBuffer = frameBuffers[0];
+static uint8_t *frontBuffer = frameBuffers[1];
+
+// Pages of the back buffer that differ from the panel, and within each page
+// one bit per changed column
+static uint8_t dirtyPages = 0;
+static uint32_t dirtyColumns[SH1106_PAGE_COUNT][SH1106_WIDTH / 32];
+#define DIRTY_SET(page)     (dirtyPages |= (1 << (page)))
+#define DIRTY_CLEAR(page)   (dirtyPages &= ~(1 << (page)))
+#define DIRTY_IS_SET(page)  (dirtyPages & (1 << (page)))
+
+// The panel shows RAM row startLine at the top of the screen, so the
+// framebuffer is a ring. Drawing works in rows counted from startLine,
+// which can run past the last page and wrap back to the first.
+static uint8_t startLine = 0;
+static volatile bool startLineDirty = false;
+#define RING_PAGE(page)     ((page) & (SH1106_PAGE_COUNT - 1))
+
+// Display start line command, sent after the spans of a frame
+static uint8_t startLineCmd[2];
+static I2CMessage startLineMsg;
+static I2CTransaction startLineTxn;
+
+// A run of columns sent as one transaction: the page and column address
+// commands, then the data. The data is sent straight from the front buffer,
+// with the byte before the span swapped for the data control byte while the
+// transaction runs.
+typedef struct {
+    I2CTransaction txn;
+    I2CMessage msgs[2];
+    uint8_t cmds[4];
+    uint8_t page;
+    uint8_t start;
+    uint8_t end;
+    uint8_t saved;
+} OledSpan;
+
+static OledSpan spans[SH1106_PAGE_COUNT * SH1106_MAX_SPANS];
+static uint8_t spanCount = 0;
+
+// Span transactions of the current frame that have not completed yet
+static volatile uint8_t pendingSpans = 0;
+
+static OledCallback frameCallback = NULL;
+static void *frameContext = NULL;
+
+static I2C_TypeDef *i2c = NULL;
+
+static uint8_t *pageData(uint8_t *frame, uint8_t page) {
+    return &frame[page * SH1106_PAGE_STRIDE + 1];
+}
+
+// Marks columns [start, end) of a page as changed
+static void markColumns(uint8_t page, uint16_t start, uint16_t end) {
+    while(start < end) {
+        uint8_t bit = start & 0x1F;
+        uint16_t n = 32 - bit;
+        if(n > end - start) {
+            n = end - start;
+        }
+
+        uint32_t mask = (n == 32) ? 0xFFFFFFFF : ((1U << n) - 1) << bit;
+        dirtyColumns[page][start >> 5] |= mask;
+        start += n;
+    }
+
+    DIRTY_SET(page);
+}
+
+static bool isColumnDirty(uint8_t page, uint8_t column) {
+    return dirtyColumns[page][column >> 5] & (1U << (column & 0x1F));
+}
+
+// Turns the dirty columns of a page into spans and clears them
+static void oledCollectSpans(uint8_t page) {
+    OledSpan *first = &spans[spanCount];
+    uint8_t count = 0;
+    uint16_t column = 0;
+
+    while(column < SH1106_WIDTH) {
+        // Skip clean words in one step
+        if(dirtyColumns[page][column >> 5] == 0) {
+            column = (column + 32) & ~0x1F;
+            continue;
+        }
+        if(!isColumnDirty(page, column)) {
+            column++;
+            continue;
+        }
+
+        uint8_t start = column;
+        while(column < SH1106_WIDTH && isColumnDirty(page, column)) {
+            column++;
+        }
+
+        if(count > 0 && (start - first[count - 1].end <= SH1106_SPAN_MERGE_GAP
+                    || count == SH1106_MAX_SPANS)) {
+            // Cheaper to resend the gap, or out of spans for this page
+            first[count - 1].end = column;
+        } else {
+            first[count].page = page;
+            first[count].start = start;
+            first[count].end = column;
+            count++;
+        }
+    }
+
+    for(int i = 0; i < SH1106_WIDTH / 32; i++) {
+        dirtyColumns[page][i] = 0;
+    }
+    DIRTY_CLEAR(page);
+
+    spanCount += count;
+}
+
+// Counts down the transactions of a frame, the last one finishes it
+static void oledFrameStep(void) {
+    pendingSpans--;
+    if(pendingSpans == 0 && frameCallback) {
+        frameCallback(frameContext);
+    }
+}
+
+// Counts off a transaction that was never started. If it was the last one
+// outstanding, the frame is over and the callback runs from here.
+static void oledSubmitFailed(void) {
+    uint32_t primask = nvicEnterCritical();
+    pendingSpans--;
+    bool done = pendingSpans == 0;
+    nvicExitCritical(primask);
+
+    if(done && frameCallback) {
+        frameCallback(frameContext);
+    }
+}
+
+static void oledSpanDone(I2CTransaction *txn) {
+    OledSpan *span = (OledSpan *)txn->context;
+
+    // Put back the column the control byte borrowed
+    span->msgs[1].buf[0] = span->saved;
+
+    oledFrameStep();
+}
+
+static void oledStartLineDone(I2CTransaction *txn) {
+    if(txn->result != I2C_OK) {
+        startLineDirty = true;
+    }
+
+    oledFrameStep();
+}
+
+void oledInit(I2C_TypeDef *i2cInit) {
+    // The panel may still be busy with a frame from before a restart
+    if(i2c != NULL) {
+        oledWait();
+    }
+
+    i2c = i2cInit;
+
+    static uint8_t init[] = {
+        0x00,       // Control byte for commands
+        0xAE,       // Display OFF
+        0xA1,       // Segment remap (optional)
+        0xC8,       // COM scan direction: remapped
+        0xA8, 0x3F, // Multiplex ratio (1/64)
+        0xD3, 0x00, // Display offset
+        0x40,       // Display start line
+        0xA6,       // Normal display
+        0xA4,       // Entire display ON from RAM
+        0xD5, 0xF0, // Display clock
+        0xD9, 0xF1, // Pre-charge
+        0xDA, 0x12, // COM pins
+        0xDB, 0x40, // VCOM detect
+        //0x8D, 0x14, // Charge pump
+        0x81, 0x7F,       // Contrast
+        0xAD, 0x8B,       // Charge pump ON (if supported)
+        0x2E,             // Deactivate scroll (important!)
+        0xAF        // Display ON
+    };
+    i2cWriteBytes(i2c, SH1106_ADDR, init, sizeof(init));
+
+    // Spans are sent in one go, which is what the DMA is best at
+    i2cEnableDma(i2c, true);
+
+    // Initialize the display to all zero
+    for(int f = 0; f < 2; f++) {
+        for(int i = 0; i < sizeof(frameBuffers[f]); i++) {
+            frameBuffers[f][i] = 0;
+        }
+
+        for(uint8_t page = 0; page < SH1106_PAGE_COUNT; page++) {
+            frameBuffers[f][page * SH1106_PAGE_STRIDE] = 0x40;
+        }
+    }
+
+    for(int i = 0; i < sizeof(spans) / sizeof(OledSpan); i++) {
+        OledSpan *span = &spans[i];
+
+        span->msgs[0] = (I2CMessage){ SH1106_ADDR, 0, sizeof(span->cmds), span->cmds };
+        span->msgs[1] = (I2CMessage){ SH1106_ADDR, 0, 0, NULL };
+
+        span->txn.msgs = span->msgs;
+        span->txn.count = 2;
+        span->txn.callback = oledSpanDone;
+        span->txn.context = span;
+        span->txn.result = I2C_OK;
+    }
+    spanCount = 0;
+
+    startLineMsg = (I2CMessage){ SH1106_ADDR, 0, sizeof(startLineCmd), startLineCmd };
+    startLineTxn.msgs = &startLineMsg;
+    startLineTxn.count = 1;
+    startLineTxn.callback = oledStartLineDone;
+
+    // The init sequence starts the display at line 0
+    startLine = 0;
+    startLineDirty = false;
+
+    // Send the whole (blank) frame first
+    for(uint8_t page = 0; page < SH1106_PAGE_COUNT; page++) {
+        markColumns(page, 0, SH1106_WIDTH);
+    }
+}
+
+bool oledUpdate(void) {
+    if(pendingSpans != 0) {
+        return false;
+    }
+
+    // Spans of the last frame that did not make it to the panel are resent
+    for(int i = 0; i < spanCount; i++) {
+        if(spans[i].txn.result != I2C_OK) {
+            markColumns(spans[i].page, spans[i].start, spans[i].end);
+        }
+    }
+    spanCount = 0;
+
+    // Don't draw anything if there are no dirty pages
+    if(dirtyPages == 0x00 && !startLineDirty) {
+        return true;
+    }
+
+    for(uint8_t page = 0; page < SH1106_PAGE_COUNT; page++) {
+        if(DIRTY_IS_SET(page)) {
+            oledCollectSpans(page);
+        }
+    }
+
+    uint8_t *frame = backBuffer;
+    backBuffer = frontBuffer;
+    frontBuffer = frame;
+
+    // Bring the new back buffer up to date, only the spans differ
+    for(int i = 0; i < spanCount; i++) {
+        uint8_t *src = pageData(frontBuffer, spans[i].page);
+        uint8_t *dst = pageData(backBuffer, spans[i].page);
+        for(int c = spans[i].start; c < spans[i].end; c++) {
+            dst[c] = src[c];
+        }
+    }
+
+    // Set before submitting, spans may complete while later ones are queued
+    bool sendStartLine = startLineDirty;
+    startLineDirty = false;
+    pendingSpans = spanCount + (sendStartLine ? 1 : 0);
+
+    for(int i = 0; i < spanCount; i++) {
+        OledSpan *span = &spans[i];
+        uint8_t column = span->start + SH1106_COLUMN_OFFSET;
+
+        span->cmds[0] = 0x00;
+        span->cmds[1] = 0xB0 | span->page;
+        span->cmds[2] = 0x00 | (column & 0x0F);
+        span->cmds[3] = 0x10 | (column >> 4);
+
+        // The control byte goes right before the first column. For column 0
+        // that is the page's own control byte.
+        uint8_t *data = &pageData(frontBuffer, span->page)[span->start] - 1;
+        span->saved = data[0];
+        data[0] = 0x40;
+        span->msgs[1].buf = data;
+        span->msgs[1].len = span->end - span->start + 1;
+
+        if(i2cSubmit(i2c, &span->txn) != I2C_OK) {
+            // Never started, so it will not complete either. The back buffer
+            // already holds its columns, mark them to go out with the next
+            // frame.
+            data[0] = span->saved;
+            span->txn.result = I2C_ERROR;
+            markColumns(span->page, span->start, span->end);
+            oledSubmitFailed();
+        }
+    }
+
+    // Scroll once the rows it brings into view have been sent
+    if(sendStartLine) {
+        startLineCmd[0] = 0x00;
+        startLineCmd[1] = 0x40 | startLine;
+
+        if(i2cSubmit(i2c, &startLineTxn) != I2C_OK) {
+            startLineDirty = true;
+            oledSubmitFailed();
+        }
+    }
+
+    return true;
+}
+
+bool oledIsBusy(void) {
+    return pendingSpans != 0;
+}
+
+void oledWait(void) {
+    while(pendingSpans != 0) {
+        i2cPollTimeout(i2c);
+    }
+}
+
+void oledSetFrameCallback(OledCallback callback, void *context) {
+    frameCallback = callback;
+    frameContext = context;
+}
+
+void oledScroll(int8_t rows) {
+    if(rows >= SH1106_HEIGHT || rows <= -SH1106_HEIGHT) {
+        // Everything scrolls out of view
+        oledDrawRectangle(0, 0, SH1106_WIDTH, SH1106_HEIGHT, false);
+        return;
+    }
+
+    if(rows > 0) {
+        startLine = (startLine + rows) & (SH1106_HEIGHT - 1);
+        // The rows that left the top come back in at the bottom
+        oledDrawRectangle(0, SH1106_HEIGHT - rows, SH1106_WIDTH, rows, false);
+    } else if(rows < 0) {
+        startLine = (startLine + SH1106_HEIGHT + rows) & (SH1106_HEIGHT - 1);
+        oledDrawRectangle(0, 0, SH1106_WIDTH, -rows, false);
+    } else {
+        return;
+    }
+
+    startLineDirty = true;
+}
+
+uint8_t oledGetStartLine(void) {
+    return startLine;
+}
+
+void oledDrawPixel(uint8_t x, uint8_t y, bool on) {
+    if(x >= SH1106_WIDTH || y >= SH1106_HEIGHT) {
+        return;
+    }
+
+    uint8_t row = y + startLine;
+    uint8_t page = RING_PAGE(row >> 3);
+    uint8_t *byte = &pageData(backBuffer, page)[x];
+    uint8_t mask = 1 << (row & 0x07);
+
+    if(on) {
+        if(*byte & mask){
+            return;
+        }
+        *byte |= mask;
+    } else {
+        if(!(*byte & mask)) {
+            return;
+        }
+        *byte &= (~mask);
+    }
+
+    markColumns(page, x, x + 1);
+}
+
+void oledDrawRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, bool on) {
+    if(x >= SH1106_WIDTH || y >= SH1106_HEIGHT || w == 0 || h == 0) {
+        return;
+    }
+
+    // One past the last column and row, clipped to the screen
+    uint16_t xEnd = x + w;
+    uint16_t yEnd = y + h;
+    if(xEnd > SH1106_WIDTH) {
+        xEnd = SH1106_WIDTH;
+    }
+    if(yEnd > SH1106_HEIGHT) {
+        yEnd = SH1106_HEIGHT;
+    }
+
+    // Move to ring rows, the pages may wrap around
+    uint16_t rowStart = y + startLine;
+    uint16_t rowEnd = yEnd + startLine;
+    uint8_t firstPage = rowStart >> 3;
+    uint8_t lastPage = (rowEnd - 1) >> 3;
+
+    for(uint8_t ringPage = firstPage; ringPage <= lastPage; ringPage++) {
+        uint8_t page = RING_PAGE(ringPage);
+
+        // Rows of this page inside the rectangle, bit 0 is the top row
+        uint8_t mask = 0xFF;
+        if(ringPage == firstPage) {
+            mask &= 0xFF << (rowStart & 0x07);
+        }
+        if(ringPage == lastPage) {
+            mask &= 0xFF >> (7 - ((rowEnd - 1) & 0x07));
+        }
+
+        uint8_t *column = &pageData(backBuffer, page)[x];
+        uint8_t *end = &pageData(backBuffer, page)[xEnd];
+        uint8_t changed = 0;
+
+        if(mask == 0xFF) {
+            // Every row of the page is covered, each column is a single store
+            uint8_t fill = on ? 0xFF : 0x00;
+            for(; column < end; column++) {
+                changed |= *column ^ fill;
+                *column = fill;
+            }
+        } else if(on) {
+            for(; column < end; column++) {
+                changed |= ~*column & mask;
+                *column |= mask;
+            }
+        } else {
+            for(; column < end; column++) {
+                changed |= *column & mask;
+                *column &= ~mask;
+            }
+        }
+
+        if(changed) {
+            markColumns(page, x, xEnd);
+        }
+    }
+}
+
+void oledDrawBitmap(uint8_t x, uint8_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, bool on) {
+    if(x >= SH1106_WIDTH || y >= SH1106_HEIGHT || w == 0 || h == 0) {
+        return;
+    }
+
+    uint16_t xEnd = x + w;
+    if(xEnd > SH1106_WIDTH) {
+        xEnd = SH1106_WIDTH;
+    }
+
+    // Bytes per bitmap column, then drop the rows below the screen
+    uint8_t stride = (h + 7) >> 3;
+    if(y + h > SH1106_HEIGHT) {
+        h = SH1106_HEIGHT - y;
+    }
+    uint8_t bitmapPages = (h + 7) >> 3;
+
+    uint8_t ringRow = y + startLine;
+    uint8_t shift = ringRow & 0x07;
+
+    for(uint8_t row = 0; row < bitmapPages; row++) {
+        uint8_t ringPage = (ringRow >> 3) + row;
+        uint8_t page = RING_PAGE(ringPage);
+
+        // Rows of the last bitmap byte past the bitmap height are ignored
+        uint8_t mask = 0xFF;
+        if(row == bitmapPages - 1 && (h & 0x07)) {
+            mask = 0xFF >> (8 - (h & 0x07));
+        }
+
+        // Unless aligned to a page, each byte straddles two pages
+        uint8_t *lower = pageData(backBuffer, page);
+        uint8_t *upper = NULL;
+        if(shift && (row < bitmapPages - 1 || (uint8_t)(mask >> (8 - shift)))) {
+            upper = pageData(backBuffer, RING_PAGE(ringPage + 1));
+        }
+
+        const uint8_t *src = &bitmap[row];
+        for(uint16_t column = x; column < xEnd; column++, src += stride) {
+            uint8_t bits = *src & mask;
+            uint8_t low = (uint8_t)(bits << shift);
+            uint8_t high = (uint8_t)(bits >> (8 - shift));
+
+            if(on) {
+                lower[column] |= low;
+                if(upper) {
+                    upper[column] |= high;
+                }
+            } else {
+                lower[column] &= ~low;
+                if(upper) {
+                    upper[column] &= ~high;
+                }
+            }
+        }
+
+        markColumns(page, x, xEnd);
+        if(upper) {
+            markColumns(RING_PAGE(ringPage + 1), x, xEnd);
+        }
+    }
+}
+
+uint8_t oledDrawChar(uint8_t x, uint8_t y, char c, const Font *font, bool on) {
+    uint8_t index = (uint8_t)c - font->first;
+
+    if((uint8_t)c >= font->first && index < font->count) {
+        uint16_t glyphSize = font->width * ((font->height + 7) >> 3);
+        oledDrawBitmap(x, y, &font->glyphs[index * glyphSize], font->width, font->height, on);
+    }
+
+    return font->width + font->spacing;
+}
+
+uint16_t oledDrawString(uint8_t x, uint8_t y, const char *str, const Font *font, bool on) {
+    uint16_t column = x;
+
+    while(*str && column < SH1106_WIDTH) {
+        column += oledDrawChar(column, y, *str++, font, on);
+    }
+
+    return column;
+}
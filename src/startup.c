@@ -1,5 +1,6 @@
 
 #include "armory/rcc.h"
+#include "armory/nvic.h"
 
 int main(void);
 
@@ -18,9 +19,86 @@ __attribute__((naked, noreturn)) void _reset(void) {
     while(1) (void) 0;  
 }
 
+// Fallback for any enabled interrupt without a handler
+void defaultHandler(void) {
+    while(1) (void) 0;
+}
+
+// Interrupt handlers used by the library. Modules provide the strong
+// definitions, anything not linked in falls back to defaultHandler.
+#define WEAK_HANDLER(name) void name(void) __attribute__((weak, alias("defaultHandler")))
+
+WEAK_HANDLER(ADC_IRQHandler);
+WEAK_HANDLER(EXTI0_IRQHandler);
+WEAK_HANDLER(EXTI1_IRQHandler);
+WEAK_HANDLER(EXTI2_IRQHandler);
+WEAK_HANDLER(EXTI3_IRQHandler);
+WEAK_HANDLER(EXTI4_IRQHandler);
+WEAK_HANDLER(EXTI9_5_IRQHandler);
+WEAK_HANDLER(EXTI15_10_IRQHandler);
+WEAK_HANDLER(TIM5_IRQHandler);
+WEAK_HANDLER(I2C1_EV_IRQHandler);
+WEAK_HANDLER(I2C1_ER_IRQHandler);
+WEAK_HANDLER(I2C2_EV_IRQHandler);
+WEAK_HANDLER(I2C2_ER_IRQHandler);
+WEAK_HANDLER(I2C3_EV_IRQHandler);
+WEAK_HANDLER(I2C3_ER_IRQHandler);
+WEAK_HANDLER(DMA1_Stream0_IRQHandler);
+WEAK_HANDLER(DMA1_Stream1_IRQHandler);
+WEAK_HANDLER(DMA1_Stream2_IRQHandler);
+WEAK_HANDLER(DMA1_Stream3_IRQHandler);
+WEAK_HANDLER(DMA1_Stream4_IRQHandler);
+WEAK_HANDLER(DMA1_Stream5_IRQHandler);
+WEAK_HANDLER(DMA1_Stream6_IRQHandler);
+WEAK_HANDLER(DMA1_Stream7_IRQHandler);
+WEAK_HANDLER(DMA2_Stream0_IRQHandler);
+WEAK_HANDLER(DMA2_Stream1_IRQHandler);
+WEAK_HANDLER(DMA2_Stream2_IRQHandler);
+WEAK_HANDLER(DMA2_Stream3_IRQHandler);
+WEAK_HANDLER(DMA2_Stream4_IRQHandler);
+WEAK_HANDLER(DMA2_Stream5_IRQHandler);
+WEAK_HANDLER(DMA2_Stream6_IRQHandler);
+WEAK_HANDLER(DMA2_Stream7_IRQHandler);
+
 extern void _estack(void);  // Defined in linker.ld
 
-// 16 standard and 42 nRF-specific handlers
-__attribute__((section(".vectors"))) void (*const tab[16 + 42])(void) = {
-    _estack, _reset
+// 16 Cortex-M4 system exceptions followed by the STM32F411 interrupts
+__attribute__((section(".vectors"))) void (*const tab[16 + NVIC_IRQ_COUNT])(void) = {
+    [0] = _estack,
+    [1] = _reset,
+
+    [16 + ADC_IRQn] = ADC_IRQHandler,
+
+    [16 + EXTI0_IRQn] = EXTI0_IRQHandler,
+    [16 + EXTI1_IRQn] = EXTI1_IRQHandler,
+    [16 + EXTI2_IRQn] = EXTI2_IRQHandler,
+    [16 + EXTI3_IRQn] = EXTI3_IRQHandler,
+    [16 + EXTI4_IRQn] = EXTI4_IRQHandler,
+    [16 + EXTI9_5_IRQn] = EXTI9_5_IRQHandler,
+    [16 + EXTI15_10_IRQn] = EXTI15_10_IRQHandler,
+    [16 + TIM5_IRQn] = TIM5_IRQHandler,
+
+    [16 + I2C1_EV_IRQn] = I2C1_EV_IRQHandler,
+    [16 + I2C1_ER_IRQn] = I2C1_ER_IRQHandler,
+    [16 + I2C2_EV_IRQn] = I2C2_EV_IRQHandler,
+    [16 + I2C2_ER_IRQn] = I2C2_ER_IRQHandler,
+    [16 + I2C3_EV_IRQn] = I2C3_EV_IRQHandler,
+    [16 + I2C3_ER_IRQn] = I2C3_ER_IRQHandler,
+
+    [16 + DMA1_Stream0_IRQn] = DMA1_Stream0_IRQHandler,
+    [16 + DMA1_Stream1_IRQn] = DMA1_Stream1_IRQHandler,
+    [16 + DMA1_Stream2_IRQn] = DMA1_Stream2_IRQHandler,
+    [16 + DMA1_Stream3_IRQn] = DMA1_Stream3_IRQHandler,
+    [16 + DMA1_Stream4_IRQn] = DMA1_Stream4_IRQHandler,
+    [16 + DMA1_Stream5_IRQn] = DMA1_Stream5_IRQHandler,
+    [16 + DMA1_Stream6_IRQn] = DMA1_Stream6_IRQHandler,
+    [16 + DMA1_Stream7_IRQn] = DMA1_Stream7_IRQHandler,
+    [16 + DMA2_Stream0_IRQn] = DMA2_Stream0_IRQHandler,
+    [16 + DMA2_Stream1_IRQn] = DMA2_Stream1_IRQHandler,
+    [16 + DMA2_Stream2_IRQn] = DMA2_Stream2_IRQHandler,
+    [16 + DMA2_Stream3_IRQn] = DMA2_Stream3_IRQHandler,
+    [16 + DMA2_Stream4_IRQn] = DMA2_Stream4_IRQHandler,
+    [16 + DMA2_Stream5_IRQn] = DMA2_Stream5_IRQHandler,
+    [16 + DMA2_Stream6_IRQn] = DMA2_Stream6_IRQHandler,
+    [16 + DMA2_Stream7_IRQn] = DMA2_Stream7_IRQHandler,
 };
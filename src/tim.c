@@ -0,0 +1,44 @@
+#include "armory/tim.h"
+#include "armory/rcc.h"
+#include "armory/bitband.h"
+
+void timInit(TIM_TypeDef *timer) {
+    if(timer == TIM1) {
+        bitbandSet(&RCC->APB2ENR, BITBAND_BIT(RCC_APB2ENR_TIM1EN));
+    } else if(timer == TIM2) {
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM2EN));
+    } else if(timer == TIM3) {
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM3EN));
+    } else if(timer == TIM4) {
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM4EN));
+    } else if(timer == TIM5) {
+        bitbandSet(&RCC->APB1ENR, BITBAND_BIT(RCC_APB1ENR_TIM5EN));
+    }
+}
+
+uint32_t timSetUpdateRate(TIM_TypeDef *timer, uint32_t rate) {
+    // TIM1 is the only one of these on APB2
+    uint32_t clock = (timer == TIM1) ? rccGetApb2TimerFreq() : rccGetApb1TimerFreq();
+    if(rate == 0 || rate > clock) {
+        return 0;
+    }
+
+    // TIM2 and TIM5 have a 32 bit auto-reload, but 16 bits is plenty here
+    uint32_t ticks = clock / rate;
+    uint32_t psc = (ticks - 1) / 0x10000;
+    if(psc > 0xFFFF) {
+        return 0;
+    }
+    uint32_t arr = ticks / (psc + 1) - 1;
+
+    bitbandClear(&timer->CR1, BITBAND_BIT(TIM_CR1_CEN));
+    timer->PSC = psc;
+    timer->ARR = arr;
+    timer->CNT = 0;
+
+    // Load the prescaler, then drop the flags the update set
+    timer->EGR = TIM_EGR_UG;
+    timer->SR = 0;
+
+    return clock / ((psc + 1) * (arr + 1));
+}
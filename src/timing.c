@@ -1,11 +1,35 @@
 
 #include "armory/timing.h"
+#include "armory/rcc.h"
 #include <stdint.h>
 
-void delay_ms(uint32_t ms) {
+void timingInit(void) {
     // Enable DWT
     DEMCR |= (1 << 24);       // Enable TRCENA
     DWT_CTRL |= 1;            // Enable CYCCNT
+}
+
+uint32_t timingUsToCycles(uint32_t us) {
+    return us * (rccGetHclkFreq() / 1000000);
+}
+
+Deadline timingDeadline(uint32_t us) {
+    timingInit();
+
+    Deadline deadline = {
+        .start = DWT_CYCCNT,
+        .cycles = timingUsToCycles(us)
+    };
+    return deadline;
+}
+
+bool timingExpired(const Deadline *deadline) {
+    // Unsigned subtraction handles CYCCNT wrapping around
+    return (DWT_CYCCNT - deadline->start) >= deadline->cycles;
+}
+
+void delay_ms(uint32_t ms) {
+    timingInit();
     uint32_t start = DWT_CYCCNT;
 
     uint32_t target = ms * 84000;  // 84 MHz = 84k cycles per ms
@@ -14,9 +38,7 @@ void delay_ms(uint32_t ms) {
 }
 
 void delay_us(uint32_t us) {
-    // Enable DWT
-    DEMCR |= (1 << 24);       // Enable TRCENA
-    DWT_CTRL |= 1;            // Enable CYCCNT
+    timingInit();
     uint32_t start = DWT_CYCCNT;
 
     uint32_t target = us * 84;  // 84 MHz = 84 cycles per us
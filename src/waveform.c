@@ -0,0 +1,121 @@
+#include "armory/waveform.h"
+#include "armory/bitband.h"
+#include "armory/dma.h"
+#include "armory/nvic.h"
+#include "armory/tim.h"
+
+static volatile bool busy = false;
+static WaveformMode playMode;
+
+static WaveformCallback eventCallback = NULL;
+static void *eventContext = NULL;
+
+// Stops TIM1 and its DMA requests, the last sample stays on the port
+static void waveformHalt(void) {
+    bitbandClear(&TIM1->CR1, BITBAND_BIT(TIM_CR1_CEN));
+    bitbandClear(&TIM1->DIER, BITBAND_BIT(TIM_DIER_UDE));
+    dmaDisableStream(DMA2, WAVEFORM_DMA_STREAM);
+    busy = false;
+}
+
+static void waveformNotify(WaveformEvent event) {
+    if(eventCallback) {
+        eventCallback(event, eventContext);
+    }
+}
+
+static void waveformDmaHandler(uint32_t flags, void *context) {
+    if(flags & DMA_FLAG_TE) {
+        waveformHalt();
+        waveformNotify(WAVEFORM_ERROR);
+        return;
+    }
+
+    if(flags & DMA_FLAG_HT) {
+        waveformNotify(WAVEFORM_HALF);
+    }
+
+    if(flags & DMA_FLAG_TC) {
+        // A looping stream reloads itself, a single pass is over
+        if(playMode == WAVEFORM_ONCE) {
+            waveformHalt();
+        }
+        waveformNotify(WAVEFORM_END);
+    }
+}
+
+void waveformEncode(uint32_t *samples, const uint16_t *values, uint16_t count, uint16_t mask) {
+    for(uint16_t i = 0; i < count; i++) {
+        samples[i] = waveformSample(values[i] & mask, ~values[i] & mask);
+    }
+}
+
+uint32_t waveformInit(uint32_t sampleRate) {
+    dmaInit(DMA2);
+    timInit(TIM1);
+
+    if(busy) {
+        waveformStop();
+    }
+
+    // No DMA requests while the rate is loaded
+    TIM1->CR1 = 0;
+    TIM1->DIER = 0;
+    TIM1->RCR = 0;
+
+    nvicSetPriority(DMA2_Stream5_IRQn, WAVEFORM_IRQ_PRIORITY);
+
+    return timSetUpdateRate(TIM1, sampleRate);
+}
+
+bool waveformStart(GPIO_TypeDef *port, const uint32_t *samples, uint16_t count, WaveformMode mode) {
+    if(busy || port == NULL || samples == NULL || count == 0) {
+        return false;
+    }
+
+    DMA_Stream_TypeDef *s = dmaGetStream(DMA2, WAVEFORM_DMA_STREAM);
+    dmaDisableStream(DMA2, WAVEFORM_DMA_STREAM);
+    dmaClearFlags(DMA2, WAVEFORM_DMA_STREAM, DMA_FLAG_ALL);
+
+    s->PAR = (uint32_t)&port->BSRR;
+    s->M0AR = (uint32_t)samples;
+    s->NDTR = count;
+    s->FCR = 0; // Direct mode, one sample per update
+
+    // Very high priority, a late sample is a glitch on the pins
+    s->CR = (WAVEFORM_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+        | (0b11U << DMA_SxCR_PL_Pos)
+        | (DMA_SIZE_WORD << DMA_SxCR_MSIZE_Pos)
+        | (DMA_SIZE_WORD << DMA_SxCR_PSIZE_Pos)
+        | DMA_SxCR_MINC | DMA_SxCR_DIR_M2P | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    if(mode == WAVEFORM_LOOP) {
+        s->CR |= DMA_SxCR_CIRC | DMA_SxCR_HTIE;
+    }
+
+    playMode = mode;
+    busy = true;
+    dmaSetCallback(DMA2, WAVEFORM_DMA_STREAM, waveformDmaHandler, NULL);
+
+    bitbandSet(&s->CR, BITBAND_BIT(DMA_SxCR_EN));
+
+    TIM1->CNT = 0;
+    TIM1->SR = 0;
+    bitbandSet(&TIM1->DIER, BITBAND_BIT(TIM_DIER_UDE));
+    bitbandSet(&TIM1->CR1, BITBAND_BIT(TIM_CR1_CEN));
+
+    return true;
+}
+
+void waveformStop(void) {
+    waveformHalt();
+    dmaClearFlags(DMA2, WAVEFORM_DMA_STREAM, DMA_FLAG_ALL);
+}
+
+bool waveformIsBusy(void) {
+    return busy;
+}
+
+void waveformSetCallback(WaveformCallback callback, void *context) {
+    eventCallback = callback;
+    eventContext = context;
+}